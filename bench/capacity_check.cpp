@@ -0,0 +1,77 @@
+#include "../include/scenario.hpp"
+#include "../include/simulation.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// runs dam_break with adaptive resolution on and a morton reorder on every
+// grid build, so the store is permuted before the first split and again
+// after every one. the capacity of every particle column, of the grid and
+// neighbour buffers and of the instance matrices has to stay what the
+// simulation reserved for Scenario::capacity(). prints the first buffer that
+// reallocated and exits 1, or if the run never split.
+// usage: capacity_check [scenario] [frames]
+
+struct Buffer {
+    const char *name;
+    size_t (*capacity)(const Simulation&);
+};
+
+#define COLUMN(column) { #column, [](const Simulation &s) { return s.particles.column.capacity(); } }
+
+static const Buffer BUFFERS[] = {
+    COLUMN(px), COLUMN(py), COLUMN(pz), COLUMN(vx), COLUMN(vy), COLUMN(vz), COLUMN(ax), COLUMN(ay), COLUMN(az),
+    COLUMN(prevX), COLUMN(prevY), COLUMN(prevZ), COLUMN(prevAx), COLUMN(prevAy), COLUMN(prevAz),
+    COLUMN(density), COLUMN(pressure), COLUMN(stiffness), COLUMN(divergenceStiffness), COLUMN(mass), COLUMN(smoothing), COLUMN(hash),
+    { "grid.particleIndex", [](const Simulation &s) { return s.grid.particleIndex.capacity(); } },
+    { "neighbours.offsets", [](const Simulation &s) { return s.neighbours.offsets.capacity(); } },
+    { "neighbours.indices", [](const Simulation &s) { return s.neighbours.indices.capacity(); } },
+    { "modelMatrices", [](const Simulation &s) { return s.modelMatrices.capacity(); } }
+};
+
+#undef COLUMN
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "resources/scenarios/dam_break.ini";
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 60;
+
+    Scenario scenario;
+    if(!scenario.load(path)) return 1;
+    scenario.solver = WCSPH;
+    scenario.adaptive = true;
+
+    Simulation simulation(scenario);
+    simulation.grid.reorderInterval = 1;
+
+    std::vector<size_t> reserved;
+    for(const Buffer &buffer : BUFFERS) reserved.push_back(buffer.capacity(simulation));
+
+    const size_t initial = simulation.particles.size();
+    size_t peak = initial;
+    unsigned int reordersAfterSplit = 0;
+
+    for(unsigned int frame = 1; frame <= frames; frame++) {
+        unsigned int rebuilds = simulation.neighbours.rebuilds;
+        simulation.step(scenario.fixedStep);
+
+        if(peak > initial) reordersAfterSplit += simulation.neighbours.rebuilds - rebuilds;
+        peak = std::max(peak, simulation.particles.size());
+
+        for(size_t b = 0; b < reserved.size(); b++) {
+            size_t capacity = BUFFERS[b].capacity(simulation);
+            if(capacity == reserved[b]) continue;
+
+            std::cout << BUFFERS[b].name << " went from " << reserved[b] << " to " << capacity << " in frame " << frame << " at "
+                      << simulation.particles.size() << " particles FAILED" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << initial << " particles split up to " << peak << " of " << scenario.capacity() << ", " << reordersAfterSplit << " reorders after the first split" << std::endl;
+
+    bool passed = peak > initial && reordersAfterSplit > 0;
+    std::cout << (passed ? "capacity ok" : "capacity FAILED, the run has to split and reorder") << std::endl;
+
+    return passed ? 0 : 1;
+}
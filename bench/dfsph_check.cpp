@@ -0,0 +1,66 @@
+#include "../include/scenario.hpp"
+#include "../include/simulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// runs double_dam_break under DFSPH and watches the mechanical energy per
+// particle (kinetic plus potential) and the fastest particle every frame. the
+// fluid only loses energy to viscosity and the walls, so it may never climb
+// above the energy of the resting columns. the splash where the two fronts
+// meet peaks below three times the free fall speed from the top of the
+// columns, a warm start that kicks particles again throws them at five times
+// that, so 3.5 times is the speed bound. exits 1 on either.
+// usage: dfsph_check [scenario] [frames]
+
+static const double ENERGY_SLACK = 1.001;
+static const double SPEED_FACTOR = 3.5;
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "resources/scenarios/double_dam_break.ini";
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 300;
+
+    Scenario scenario;
+    if(!scenario.load(path)) return 1;
+    scenario.solver = DFSPH;
+
+    Simulation simulation(scenario);
+    const ParticleSystem &particles = simulation.particles;
+
+    double top = 0.0;
+    for(size_t i = 0; i < particles.size(); i++) top = std::max(top, (double)particles.py[i]);
+
+    const double maxSpeed = SPEED_FACTOR * std::sqrt(2.0 * -particles.gravity * top);
+
+    double initial = 0.0, peakEnergy = 0.0, peakSpeed = 0.0;
+    unsigned int energyFrame = 0, speedFrame = 0;
+
+    for(unsigned int frame = 0; frame <= frames; frame++) {
+        if(frame > 0) simulation.step(scenario.fixedStep);
+
+        double energy = 0.0, speed = 0.0;
+        for(size_t i = 0; i < particles.size(); i++) {
+            glm::vec3 velocity = particles.velocity(i);
+
+            energy += 0.5 * glm::dot(velocity, velocity) - particles.gravity * particles.py[i];
+            speed = std::max(speed, (double)glm::length(velocity));
+        }
+        energy /= particles.size();
+
+        if(frame == 0) initial = energy;
+        if(energy > peakEnergy) { peakEnergy = energy; energyFrame = frame; }
+        if(speed > peakSpeed) { peakSpeed = speed; speedFrame = frame; }
+    }
+
+    bool energyOk = peakEnergy <= ENERGY_SLACK * initial;
+    bool speedOk = peakSpeed <= maxSpeed;
+
+    std::cout << particles.size() << " particles, " << frames << " frames" << std::endl;
+    std::cout << "energy per particle " << initial << " at rest, peak " << peakEnergy << " in frame " << energyFrame << (energyOk ? "" : " FAILED") << std::endl;
+    std::cout << "fastest particle " << peakSpeed << " in frame " << speedFrame << ", bound " << maxSpeed << (speedOk ? "" : " FAILED") << std::endl;
+    std::cout << (energyOk && speedOk ? "dfsph ok" : "dfsph FAILED") << std::endl;
+
+    return energyOk && speedOk ? 0 : 1;
+}
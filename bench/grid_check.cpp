@@ -0,0 +1,76 @@
+#include "../include/constants.hpp"
+#include "../include/particle_system.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/uniform_grid.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// builds a hashed grid over a random cloud, then grows the cloud to several
+// times the size the grid was constructed for and spreads it over more cells
+// than the initial table has slots, the way adaptive splitting grows the store.
+// after every build each particle has to be listed exactly once, in the cell
+// its own position maps to, and every cell may only hold particles of that
+// cell. prints the first mismatch and exits 1 on failure.
+// usage: grid_check [particle count]
+
+static bool consistent(const ParticleSystem &particles, const UniformGrid &grid) {
+    std::vector<unsigned int> listed(particles.size(), 0);
+
+    for(size_t c = 0; c < grid.cellCount(); c++) {
+        for(uint32_t k = grid.cellStart[c]; k < grid.cellEnd[c]; k++) {
+            uint32_t i = grid.particleIndex[k];
+            listed[i]++;
+
+            if(grid.cellIndex(grid.cellCoord(particles.position(i))) != c) {
+                std::cout << "particle " << i << " is listed in cell " << c << " but maps to another one" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    for(size_t i = 0; i < particles.size(); i++) {
+        if(listed[i] != 1) {
+            std::cout << "particle " << i << " is listed " << listed[i] << " times" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void scatter(ParticleSystem &particles, size_t count, float extent, std::mt19937 &random) {
+    std::uniform_real_distribution<float> coordinate(-extent, extent);
+
+    for(size_t i = 0; i < count; i++) {
+        particles.add(glm::vec3(coordinate(random), coordinate(random), coordinate(random)));
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+    ThreadPool pool(THREAD_COUNT, CHUNK_SIZE);
+    std::mt19937 random(1);
+
+    ParticleSystem particles;
+    UniformGrid grid(SMOOTHING_RADIUS, count);
+
+    // the third round has more particles and far more occupied cells than the table was made for
+    const float extents[] = { BOX_SIZE, BOX_SIZE, 100.0f * BOX_SIZE };
+    const size_t added[] = { count, 3 * count, 4 * count };
+
+    for(int round = 0; round < 3; round++) {
+        scatter(particles, added[round], extents[round], random);
+        grid.build(particles, pool);
+
+        std::cout << particles.size() << " particles in " << grid.cellCount() << " cells" << std::endl;
+
+        if(!consistent(particles, grid)) return 1;
+    }
+
+    std::cout << "hashed grid ok" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "../include/scenario.hpp"
+#include "../include/simulation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// runs the same scenario under WCSPH in a float and a double Simulation side
+// by side, boundary particles and all, and reports the time per step of each
+// and how far the float positions have drifted from the double ones every
+// tenth of the run. a second float run has the compile time kernel switched
+// off, when the scenario's radius is the compiled in one it has to stay bit
+// for bit with the first and shows what folding the kernel constants is worth.
+// adaptive resolution and sleeping are off and the store is never reordered,
+// so particle i stays particle i in every run.
+// usage: real_benchmark [scenario] [steps]
+
+template <typename Real>
+class Run {
+public:
+    BasicSimulation<Real> simulation;
+
+    double milliseconds;
+
+    Run(const Scenario &scenario, float deltaTime) : simulation(scenario), milliseconds(0.0) {
+        this->simulation.grid.reorderInterval = 0;
+
+        // every advance() is exactly one substep of deltaTime
+        this->simulation.timestep.minStep = deltaTime;
+        this->simulation.timestep.maxStep = deltaTime;
+    }
+
+    void step(float deltaTime) {
+        auto start = std::chrono::steady_clock::now();
+        this->simulation.advance(deltaTime);
+        this->milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+int main(int argc, char **argv) {
+    Scenario scenario;
+    if(argc > 1 && !scenario.load(argv[1])) return 1;
+
+    unsigned int steps = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    scenario.solver = WCSPH;
+    scenario.adaptive = false;
+    scenario.sleeping = false;
+
+    // well inside the CFL bound h / c of the Tait stiffness
+    const float deltaTime = 0.1f * scenario.smoothingRadius / scenario.soundSpeed;
+
+    Run<float> single(scenario, deltaTime);
+    Run<double> twice(scenario, deltaTime);
+    Run<float> runtime(scenario, deltaTime);
+
+    bool fixed = single.simulation.solver->fixedKernel;
+    runtime.simulation.solver->fixedKernel = false;
+
+    const BasicParticleSystem<float> &a = single.simulation.particles;
+    const BasicParticleSystem<double> &b = twice.simulation.particles;
+    const BasicParticleSystem<float> &c = runtime.simulation.particles;
+
+    std::cout << a.size() << " particles, " << steps << " steps of " << deltaTime << " s, " << single.simulation.pool.size() << " threads";
+    std::cout << (fixed ? "" : ", the radius is not the compiled in one") << std::endl;
+
+    for(unsigned int i = 1; i <= steps; i++) {
+        single.step(deltaTime);
+        twice.step(deltaTime);
+        runtime.step(deltaTime);
+
+        if(i % std::max(steps / 10, 1u) != 0 && i != steps) continue;
+
+        double sum2 = 0.0, max = 0.0;
+        size_t differing = 0;
+
+        for(size_t k = 0; k < a.size(); k++) {
+            double drift = glm::length(glm::dvec3(a.position(k)) - b.position(k));
+
+            sum2 += drift * drift;
+            max = std::max(max, drift);
+            differing += a.position(k) != c.position(k);
+        }
+
+        std::cout << "t " << i * (double)deltaTime << " s drift rms " << std::sqrt(sum2 / a.size()) << " max " << max;
+        std::cout << ", runtime kernel differs in " << differing << " particles" << std::endl;
+    }
+
+    std::cout << "float  " << single.milliseconds / steps << " ms/step" << std::endl;
+    std::cout << "double " << twice.milliseconds / steps << " ms/step" << std::endl;
+    std::cout << "float, runtime kernel " << runtime.milliseconds / steps << " ms/step" << std::endl;
+    std::cout << "drift is in scene units, the particle spacing is " << scenario.spacing << std::endl;
+
+    return 0;
+}
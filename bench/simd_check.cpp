@@ -0,0 +1,138 @@
+#include "../include/constants.hpp"
+#include "../include/neighbour_list.hpp"
+#include "../include/particle_system.hpp"
+#include "../include/simd_kernels.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/uniform_grid.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// evaluates every neighbour loop of simd_kernels.hpp at every level the cpu
+// supports, for the run time and the compile time kernel, and compares each
+// against the scalar path on a jittered lattice with random velocities and
+// pressures. errors are relative to the largest scalar result of the loop
+// over all particles, so near zero sums do not blow them up. the packed
+// records have to match the scalar packing bit for bit. prints the worst
+// error of every loop and exits 1 if one is above the tolerance.
+// usage: simd_check [row count]
+
+static const double TOLERANCE = 1e-6;
+
+static const char *LEVEL_NAMES[] = { "scalar", "avx2", "avx512" };
+
+struct Worst {
+    double error = 0.0;
+    double scale = 0.0;
+
+    void add(glm::vec3 value, glm::vec3 reference) {
+        this->error = std::max(this->error, (double)glm::length(value - reference));
+        this->scale = std::max(this->scale, (double)glm::length(reference));
+    }
+
+    double relative() const { return this->scale > 0.0 ? this->error / this->scale : this->error; }
+};
+
+template <typename Kernel>
+static bool check(const char *name, const Kernel &kernel, const ParticleSystem &particles, const NeighbourList &neighbours) {
+    const BasicSimdKernels<Kernel> reference(SCALAR);
+    const size_t n = particles.size();
+    const size_t words = BasicSimdKernels<Kernel>::PACKED_WORDS;
+
+    std::vector<uint32_t> referencePacked(words * n), packed(words * n);
+    reference.pack(particles, 0, n, referencePacked.data());
+
+    bool passed = true;
+
+    for(Simd_Level level : { AVX2, AVX512 }) {
+        const BasicSimdKernels<Kernel> simd(level);
+        if(simd.level() != level) continue;
+
+        Worst density, pressure, viscosity, packedPressure, packedViscosity;
+
+        for(size_t i = 0; i < n; i++) {
+            const uint32_t *list = neighbours.begin(i);
+            uint32_t count = neighbours.count(i);
+
+            density.add(glm::vec3(simd.densitySum(kernel, particles, i, list, count)), glm::vec3(reference.densitySum(kernel, particles, i, list, count)));
+
+            ForceSums sums = simd.forceSums(kernel, particles, i, list, count);
+            ForceSums expected = reference.forceSums(kernel, particles, i, list, count);
+            pressure.add(sums.pressure, expected.pressure);
+            viscosity.add(sums.viscosity, expected.viscosity);
+
+            sums = simd.forceSums(kernel, particles, referencePacked.data(), i, list, count);
+            expected = reference.forceSums(kernel, particles, referencePacked.data(), i, list, count);
+            packedPressure.add(sums.pressure, expected.pressure);
+            packedViscosity.add(sums.viscosity, expected.viscosity);
+        }
+
+        simd.pack(particles, 0, n, packed.data());
+        bool packMatches = packed == referencePacked;
+
+        const char *levelName = LEVEL_NAMES[level];
+        const std::pair<const char*, const Worst*> loops[] = {
+            { "density", &density }, { "pressure", &pressure }, { "viscosity", &viscosity },
+            { "packed pressure", &packedPressure }, { "packed viscosity", &packedViscosity }
+        };
+
+        for(const auto &loop : loops) {
+            bool ok = loop.second->relative() <= TOLERANCE;
+            passed = passed && ok;
+
+            std::cout << name << " " << levelName << " " << loop.first << ": " << loop.second->relative() << (ok ? "" : " FAILED") << std::endl;
+        }
+
+        std::cout << name << " " << levelName << " pack: " << (packMatches ? "identical" : "differs FAILED") << std::endl;
+        passed = passed && packMatches;
+    }
+
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    unsigned int rows = argc > 1 ? std::atoi(argv[1]) : PARTICLE_ROW_COUNT;
+
+    ThreadPool pool(THREAD_COUNT, CHUNK_SIZE);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    // a lattice jittered by a fifth of the spacing so distances cover the whole support
+    ParticleSystem particles;
+    particles.reserve((size_t)rows * rows * rows);
+
+    for(unsigned int x = 0; x < rows; x++) {
+        for(unsigned int y = 0; y < rows; y++) {
+            for(unsigned int z = 0; z < rows; z++) {
+                glm::vec3 jitter(unit(random), unit(random), unit(random));
+                glm::vec3 velocity(unit(random), unit(random), unit(random));
+
+                particles.add(TRANSLATE * (glm::vec3(x, y, z) + 0.2f * jitter), 10.0f * velocity);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < particles.size(); i++) {
+        particles.density[i] = REST_DENSITY * (1.0f + 0.05f * unit(random));
+        particles.pressure[i] = 1000.0f * unit(random);
+    }
+
+    UniformGrid grid(SMOOTHING_RADIUS, glm::vec3(-TRANSLATE), glm::vec3(TRANSLATE * rows));
+    NeighbourList neighbours(SMOOTHING_RADIUS, particles.size());
+
+    grid.reorderInterval = 0;
+    neighbours.update(particles, grid, pool);
+
+    std::cout << particles.size() << " particles, the cpu supports up to " << LEVEL_NAMES[SimdKernels::detect()] << std::endl;
+
+    bool passed = check("runtime kernel", SphKernel(SMOOTHING_RADIUS), particles, neighbours);
+    passed = check("fixed kernel", DefaultSphKernel(), particles, neighbours) && passed;
+
+    std::cout << (passed ? "simd kernels ok" : "simd kernels FAILED") << std::endl;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#ifndef ADAPTIVE_RESOLUTION_H
+#define ADAPTIVE_RESOLUTION_H
+
+#include "aligned_allocator.hpp"
+#include "glm/glm.hpp"
+#include "neighbour_list.hpp"
+#include "particle_system.hpp"
+#include "sph_kernels.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// splits particles where detail is visible and merges them back where it is
+// not. a particle is split in two halves when it sits at the free surface
+// (density below surfaceDensity rho_0) or within focusRadius of focus, two
+// particles of equal mass are merged when both are deep inside (density above
+// interiorDensity rho_0), calm and away from the focus. masses stay within
+// [minMass, 1] of the base particle, so the support never grows past the
+// radius the neighbour lists are built with.
+//
+// a split keeps the velocity and puts the halves half a spacing of their own
+// size apart, a merge puts the result at the centre of mass with the mean
+// momentum, so mass and momentum are conserved exactly. the support of a
+// particle is cbrt(mass) h, pairs use the mean of the two
+class AdaptiveResolution {
+public:
+    bool enabled;
+
+    SphKernel kernel;
+    float spacing;
+    float minMass;
+    size_t maxParticles;
+
+    float surfaceDensity;
+    float interiorDensity;
+    float calmSpeed;
+
+    glm::vec3 focus;
+    float focusRadius;
+
+    // fixed steps between two passes
+    unsigned int interval;
+
+    // particle shifting of the fresh halves, pairs of halves raise the density
+    // estimate by a few percent and the pressure solvers would answer that
+    // with a kick in a single step
+    unsigned int relaxIterations;
+    float relaxStrength;
+
+    // of the last pass
+    unsigned int splits;
+    unsigned int merges;
+
+    AdaptiveResolution(float smoothingRadius, float spacing, float minMass, size_t maxParticles, float surfaceDensity, float interiorDensity, float calmSpeed,
+                       float focusRadius, unsigned int interval);
+
+    // counts fixed steps and runs a pass every interval of them. neighbours
+    // has to list the current indices of particles, the densities are the
+    // ones of the last solver step. returns true when the store changed.
+    // instantiated for float and double stores, the placement is worked out
+    // in float either way
+    template <typename Real>
+    bool update(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours, float restDensity, ThreadPool &pool);
+
+    // sizes the per-particle scratch of a pass for capacity particles
+    void reserve(size_t capacity);
+
+private:
+    enum Action : uint8_t {
+        KEEP,
+        SPLIT,
+        MERGE,
+        REMOVED
+    };
+
+    unsigned int counter;
+
+    std::vector<uint8_t> actions;
+
+    // index of the second half of a particle split in this pass
+    std::vector<uint32_t> children;
+    std::vector<uint32_t> order;
+
+    template <typename Real>
+    void classify(const BasicParticleSystem<Real> &particles, float restDensity, ThreadPool &pool);
+    template <typename Real>
+    void merge(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours);
+    template <typename Real>
+    void split(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours);
+    template <typename Real>
+    void relax(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours);
+    template <typename Real>
+    void compact(BasicParticleSystem<Real> &particles);
+};
+
+#endif
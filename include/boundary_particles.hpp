@@ -0,0 +1,62 @@
+#ifndef BOUNDARY_PARTICLES_H
+#define BOUNDARY_PARTICLES_H
+
+#include "aligned_allocator.hpp"
+#include "glm/glm.hpp"
+#include "neighbour_list.hpp"
+#include "particle_system.hpp"
+#include "sph_kernels.hpp"
+#include "thread_pool.hpp"
+#include "uniform_grid.hpp"
+
+// static boundary particles after Akinci et al. 2012. the floor and the four
+// walls of the box are sampled once, offset outside the planes the integrator
+// clamps to, and binned into a grid of their own that is never rebuilt. the
+// offset is about one fluid spacing, the distance at which a fluid particle
+// resting against the wall reaches rest density. each boundary particle b
+// carries psi_b = rho_0 V_b with V_b = 1 / sum_b' W_bb', so a sparse or dense
+// sampling contributes the same density and pressure to the fluid.
+//
+// neighbours lists the boundary particles near every fluid particle and is
+// rebuilt together with the fluid lists. the offset is tuned for the base
+// support, so split fluid particles also see the walls with the full h.
+//
+// the samples and psi are held in the Real of the fluid store, instantiated
+// for float and double in boundary_particles.cpp
+template <typename Real>
+class BasicBoundaryParticles {
+public:
+    using Vec3 = glm::vec<3, Real>;
+
+    float spacing;
+    float offset;
+
+    // only the position columns are used
+    BasicParticleSystem<Real> particles;
+    AlignedVector<Real> psi;
+
+    UniformGrid grid;
+    NeighbourList neighbours;
+
+    // samples the floor and walls of [boxMin, boxMax], the top stays open
+    BasicBoundaryParticles(float spacing, float offset, glm::vec3 boxMin, glm::vec3 boxMax, const BasicSphKernel<Real> &kernel, Real restDensity,
+                           float skin, size_t fluidCount, ThreadPool &pool);
+
+    size_t size() const { return this->particles.size(); }
+
+    void update(const BasicParticleSystem<Real> &fluid, ThreadPool &pool);
+
+    // sum_b psi_b W_poly6(x_i - x_b)
+    Real density(const BasicSphKernel<Real> &kernel, const BasicParticleSystem<Real> &fluid, size_t i) const;
+
+    // sum_b psi_b grad W_spiky(x_i - x_b)
+    Vec3 gradient(const BasicSphKernel<Real> &kernel, const BasicParticleSystem<Real> &fluid, size_t i) const;
+
+private:
+    void sample(glm::vec3 boxMin, glm::vec3 boxMax);
+    void computePsi(const BasicSphKernel<Real> &kernel, Real restDensity, ThreadPool &pool);
+};
+
+using BoundaryParticles = BasicBoundaryParticles<float>;
+
+#endif
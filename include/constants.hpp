@@ -1,15 +1,71 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
-#include <cmath>
-
 const unsigned int WIDTH = 800;
 const unsigned int HEIGHT = 600;
-const unsigned int PARTICLE_ROW_COUNT = 15;
-const unsigned int PARTICLE_COUNT = std::pow(PARTICLE_ROW_COUNT, 3.0f);
-const float BOX_SIZE = 50.0f;
-const float TRANSLATE = BOX_SIZE / PARTICLE_ROW_COUNT;
+const char* const SCENARIO_PATH = "resources/scenarios/dam_break.ini";
+const char* const COLLIDER_CACHE_PATH = "build/sphere.sdf";
+constexpr unsigned int PARTICLE_ROW_COUNT = 15;
+constexpr float BOX_SIZE = 50.0f;
+constexpr float TRANSLATE = BOX_SIZE / PARTICLE_ROW_COUNT;
 const float SCALE = 0.01f;
+constexpr float SMOOTHING_FACTOR = 2.0f;
+constexpr float SMOOTHING_RADIUS = SMOOTHING_FACTOR * TRANSLATE;
+const float FIXED_KERNEL_TOLERANCE = 1e-6f;
+const unsigned int REORDER_INTERVAL = 32;
+const float VERLET_SKIN_FACTOR = 0.1f;
+const unsigned int NEIGHBOUR_RESERVE = 96;
+const float BOUNDARY_OFFSET_FACTOR = 1.2f;
+const float COLLIDER_RADIUS_FACTOR = 0.25f;
+const float COLLIDER_OFFSET_FACTOR = -0.5f;
+const float COLLIDER_CELL_FACTOR = 0.5f;
+const float COLLIDER_BAND_FACTOR = 2.0f;
+const float PARTICLE_RADIUS_FACTOR = 0.5f;
+const bool COLLIDER = true;
+const bool ADAPTIVE_RESOLUTION = false;
+const float ADAPTIVE_MIN_MASS = 0.125f;
+const unsigned int ADAPTIVE_MAX_FACTOR = 2;
+const float ADAPTIVE_SURFACE_DENSITY = 0.85f;
+const float ADAPTIVE_INTERIOR_DENSITY = 0.99f;
+const float ADAPTIVE_CALM_SPEED = 2.0f;
+const float ADAPTIVE_FOCUS_FACTOR = 1.0f;
+const unsigned int ADAPTIVE_INTERVAL = 10;
+const unsigned int ADAPTIVE_RELAX_ITERATIONS = 4;
+const float ADAPTIVE_RELAX_STRENGTH = 0.01f;
+const bool SLEEPING = false;
+const float SLEEP_SPEED = 0.5f;
+const float SLEEP_DENSITY_CHANGE = 0.001f;
+const unsigned int SLEEP_STEPS = 30;
+const unsigned int THREAD_COUNT = 0;
+const unsigned int CHUNK_SIZE = 256;
+const bool PACKED_FORCES = true;
 const float GRAVITY = -9.81f;
+const float CFL_FACTOR = 0.3f;
+const float FORCE_FACTOR = 0.25f;
+const float MIN_TIMESTEP = 0.0005f;
+const float MAX_TIMESTEP = 0.05f;
+const float FIXED_TIMESTEP = 1.0f / 60.0f;
+const unsigned int MAX_FRAME_STEPS = 4;
+const float REST_DENSITY = 1000.0f;
+const float SOUND_SPEED = 80.0f;
+const float TAIT_EXPONENT = 7.0f;
+const float VISCOSITY = 4000.0f;
+const float PCISPH_TOLERANCE = 0.01f;
+const unsigned int PCISPH_MIN_ITERATIONS = 3;
+const unsigned int PCISPH_MAX_ITERATIONS = 50;
+const float DFSPH_DENSITY_TOLERANCE = 0.001f;
+const float DFSPH_DIVERGENCE_TOLERANCE = 0.01f;
+const unsigned int DFSPH_MAX_ITERATIONS = 100;
+const unsigned int DFSPH_MIN_NEIGHBOURS = 20;
+const float DFSPH_WARM_START_LIMIT = 0.02f;
+const float IISPH_OMEGA = 0.5f;
+const float IISPH_TOLERANCE = 0.001f;
+const unsigned int IISPH_MIN_ITERATIONS = 2;
+const unsigned int IISPH_MAX_ITERATIONS = 100;
+const unsigned int PBF_ITERATIONS = 4;
+const float PBF_RELAXATION = 0.01f;
+const float PBF_CORRECTION_K = 0.1f;
+const unsigned int PBF_CORRECTION_N = 4;
+const float PBF_CORRECTION_DQ = 0.2f;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef DFSPH_SOLVER_H
+#define DFSPH_SOLVER_H
+
+#include "aligned_allocator.hpp"
+#include "solver.hpp"
+
+// divergence-free SPH (Bender and Koschier 2015). per step the velocities are
+// first made divergence free, then the predicted velocities are corrected
+// until the density they lead to is at rest density. both solves share the
+// per-particle factors alpha and start from half of the stiffness the
+// particle ended the previous step with, if it still needs a correction
+class DfsphSolver : public Solver {
+public:
+    float densityTolerance;
+    float divergenceTolerance;
+    unsigned int maxIterations;
+
+    // the divergence solve skips particles with fewer neighbours, self included
+    unsigned int minNeighbours;
+
+    // the warm start carries at most the stiffness of this relative density
+    // error over, a particle that was hit hard last step is not kicked again
+    float warmStartLimit;
+
+    // iterations and average relative error of the two solves in the last step
+    unsigned int densityIterations;
+    unsigned int divergenceIterations;
+    float densityError;
+    float divergenceError;
+
+    DfsphSolver(float smoothingRadius, float spacing);
+
+    Solver_Type type() const override { return DFSPH; }
+    const char* name() const override { return "DFSPH"; }
+
+    // the density solve diverges within a few hundred frames of the first
+    // splits, so adaptive resolution stays paused under DFSPH
+    bool mixedSizes() const override { return false; }
+    bool requiresEuler() const override { return true; }
+
+    void step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) override;
+    void reserve(size_t capacity) override { this->resize(capacity); }
+
+private:
+    // rho_i / (|sum_j m grad W_ij|^2 + sum_j |m grad W_ij|^2)
+    AlignedVector<float> alpha;
+    AlignedVector<float> vx0, vy0, vz0;
+
+    // sum_b psi_b grad W_ib, fixed for the whole step
+    AlignedVector<float> gbx, gby, gbz;
+
+    void resize(size_t n);
+
+    // every pass runs on the kernel step() picked, see Solver::fixedKernel
+    template <typename Kernel>
+    void step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+              float deltaTime);
+
+    template <typename Kernel>
+    void computeFactors(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, const NeighbourList &neighbours, size_t begin,
+                        size_t end);
+
+    // sum_j m (v_i - v_j) . grad W_ij
+    template <typename Kernel>
+    float densityChange(const Kernel &kernel, const ParticleSystem &particles, const NeighbourList &neighbours, size_t i) const;
+
+    // density correction particle i still needs, compressions only
+    template <typename Kernel>
+    float source(const Kernel &kernel, const ParticleSystem &particles, const NeighbourList &neighbours, size_t i, float deltaTime, bool divergence) const;
+
+    // corrects the velocities with the stiffness held in the pressure column
+    template <typename Kernel>
+    void applyStiffness(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, const NeighbourList &neighbours, ThreadPool &pool,
+                        float deltaTime);
+
+    // stored is the particle column carrying the stiffness between steps,
+    // returns the number of velocity corrections
+    template <typename Kernel>
+    unsigned int solve(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, const NeighbourList &neighbours, ThreadPool &pool,
+                       float deltaTime, AlignedVector<float> &stored, bool divergence, float tolerance, unsigned int minIterations, float &error);
+};
+
+#endif
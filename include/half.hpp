@@ -0,0 +1,80 @@
+#ifndef HALF_H
+#define HALF_H
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 conversions for cpus without F16C, rounding to nearest
+// even like _mm256_cvtps_ph does (after F. Giesen's float_to_half_fast3_rtne
+// and half_to_float). overflow goes to infinity, NaN stays NaN
+
+inline uint16_t toHalf(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+
+    uint32_t sign = x & 0x80000000u;
+    x ^= sign;
+
+    uint16_t half;
+
+    if(x >= 0x47800000u) {
+        half = x > 0x7f800000u ? 0x7e00 : 0x7c00;
+    } else if(x < 0x38800000u) {
+        // subnormal or zero, adding 0.5 lines the 10 mantissa bits up at the bottom
+        const uint32_t magic = 0x3f000000u;
+
+        float f, m;
+        std::memcpy(&f, &x, sizeof(f));
+        std::memcpy(&m, &magic, sizeof(m));
+        f += m;
+
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        half = (uint16_t)(bits - magic);
+    } else {
+        uint32_t odd = (x >> 13) & 1u;
+        x += 0xc8000fffu + odd;
+        half = (uint16_t)(x >> 13);
+    }
+
+    return half | (uint16_t)(sign >> 16);
+}
+
+inline float fromHalf(uint16_t half) {
+    const uint32_t exponentMask = 0x7c00u << 13;
+
+    uint32_t x = (uint32_t)(half & 0x7fffu) << 13;
+    uint32_t exponent = x & exponentMask;
+    x += (127u - 15u) << 23;
+
+    float value;
+
+    if(exponent == exponentMask) {
+        x += (128u - 16u) << 23;
+        std::memcpy(&value, &x, sizeof(value));
+    } else if(exponent == 0) {
+        const uint32_t magic = 113u << 23;
+        float m;
+        std::memcpy(&m, &magic, sizeof(m));
+
+        x += 1u << 23;
+        std::memcpy(&value, &x, sizeof(value));
+        value -= m;
+    } else {
+        std::memcpy(&value, &x, sizeof(value));
+    }
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits |= (uint32_t)(half & 0x8000u) << 16;
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+// two halves in one word, a in the low 16 bits
+inline uint32_t packHalves(float a, float b) {
+    return (uint32_t)toHalf(a) | (uint32_t)toHalf(b) << 16;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef IISPH_SOLVER_H
+#define IISPH_SOLVER_H
+
+#include "aligned_allocator.hpp"
+#include "solver.hpp"
+
+// implicit incompressible SPH (Ihmsen et al. 2014). the velocities are advected
+// with the non-pressure forces, then the pressure Poisson equation is solved
+// with relaxed Jacobi. every pass reads the previous iterate and writes only
+// its own particle so the ranges run in parallel without locks. the pressure
+// column doubles as the warm start of the next step
+class IisphSolver : public Solver {
+public:
+    float omega;
+    float tolerance;
+    unsigned int minIterations;
+    unsigned int maxIterations;
+
+    // average relative density error after the last step
+    float densityError;
+
+    IisphSolver(float smoothingRadius, float spacing);
+
+    Solver_Type type() const override { return IISPH; }
+    const char* name() const override { return "IISPH"; }
+
+    void step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) override;
+    void reserve(size_t capacity) override { this->resize(capacity); }
+
+private:
+    // non-pressure accelerations
+    AlignedVector<float> anx, any, anz;
+
+    // d_ii = -dt^2 / rho_i^2 (sum_j m_j grad W_ij + sum_b psi_b grad W_ib) and sum_j d_ij p_j
+    AlignedVector<float> diix, diiy, diiz;
+    AlignedVector<float> sumx, sumy, sumz;
+
+    // sum_b psi_b grad W_ib, fixed for the whole step
+    AlignedVector<float> gbx, gby, gbz;
+
+    AlignedVector<float> aii;
+    AlignedVector<float> advectedDensity;
+    AlignedVector<float> nextPressure;
+
+    void resize(size_t n);
+
+    template <typename Kernel>
+    void step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+              float deltaTime);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef INTEGRATORS_H
+#define INTEGRATORS_H
+
+// time integration schemes for ParticleSystem::integrate. each advances one
+// component of one particle and is passed as a template parameter, so the
+// scheme inlines into the SoA loop without any dispatch. a is the full
+// acceleration of this step (gravity included), previousA is a per-particle
+// slot the scheme may keep between steps and previousDeltaTime is 0 on the
+// first step. the schemes are templated on the scalar type so the float and
+// the double store share them
+
+// v += a dt, x += v dt. first order but symplectic, and the scheme the
+// position based solvers (DFSPH, PBF) assume when they turn their velocity
+// changes into accelerations
+struct SemiImplicitEuler {
+    template <typename Real>
+    static inline void step(Real &x, Real &v, Real& /* previousA */, Real a, Real deltaTime, Real /* previousDeltaTime */) {
+        v += a * deltaTime;
+        x += v * deltaTime;
+    }
+};
+
+// kick-drift leapfrog with the velocities living at the half steps. the kick
+// spans the two half steps around the force evaluation, which keeps the
+// scheme time reversible when the controller changes the step size, and the
+// first step is the half kick that staggers the velocities
+struct Leapfrog {
+    template <typename Real>
+    static inline void step(Real &x, Real &v, Real& /* previousA */, Real a, Real deltaTime, Real previousDeltaTime) {
+        v += Real(0.5) * (previousDeltaTime + deltaTime) * a;
+        x += v * deltaTime;
+    }
+};
+
+// velocity Verlet with one force evaluation per step. the stored velocity is
+// the prediction v_n + a_n dt the solver sees, it is corrected to
+// v_n + (a_n + a_n+1) dt / 2 once the new acceleration is known
+struct VelocityVerlet {
+    template <typename Real>
+    static inline void step(Real &x, Real &v, Real &previousA, Real a, Real deltaTime, Real previousDeltaTime) {
+        v += Real(0.5) * previousDeltaTime * (a - previousA);
+        x += v * deltaTime + Real(0.5) * a * deltaTime * deltaTime;
+        v += a * deltaTime;
+
+        previousA = a;
+    }
+};
+
+#endif
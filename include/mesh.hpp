@@ -35,9 +35,13 @@ public:
     void draw(Shader &shader) const;
     void drawInstanced(Shader &shader, const std::vector<glm::mat4> &modelMatrices);
 
+    // allocates the instance buffer for count model matrices
+    void reserveInstances(size_t count);
+
 private:
     unsigned int VAO, VBO, EBO;
     unsigned int instanceVBO = 0;
+    size_t instanceCapacity = 0;
 
     void setupMesh();
 
@@ -19,6 +19,10 @@ public:
     
     void draw(Shader &shader) const;
     void drawInstanced(Shader &shader, const std::vector<glm::mat4> &modelMatrices);
+    void reserveInstances(size_t count);
+
+    // corners of every triangle of every mesh, three per triangle, moved by transform
+    std::vector<glm::vec3> triangles(const glm::mat4 &transform = glm::mat4(1.0f)) const;
 
 private:
     std::vector<Texture> textures_loaded;
@@ -0,0 +1,76 @@
+#ifndef NEIGHBOUR_LIST_H
+#define NEIGHBOUR_LIST_H
+
+#include "aligned_allocator.hpp"
+#include "particle_system.hpp"
+#include "uniform_grid.hpp"
+
+#include <cstdint>
+
+// compressed sparse row neighbour lists, the neighbours of particle i are
+// indices[offsets[i]] .. indices[offsets[i + 1] - 1] and include i itself.
+// both arrays are sized once and reused every frame.
+//
+// with a non-zero skin these are verlet lists: they are built with radius
+// + skin and update() only rebuilds them once some particle has moved more
+// than skin / 2 since the last build, so they may hold particles slightly
+// outside radius and consumers must still test the distance. the grid cell
+// size has to be at least radius + skin.
+//
+// the lists can also point into a second particle store, the static boundary
+// particles use that to hand every fluid particle its boundary neighbours.
+// like the grid the entry points take a float or a double store
+class NeighbourList {
+public:
+    float radius;
+    float skin;
+
+    // list entries reserved per particle
+    size_t expectedNeighbours;
+
+    AlignedVector<uint32_t> offsets;
+    AlignedVector<uint32_t> indices;
+
+    unsigned int updates;
+    unsigned int rebuilds;
+
+    NeighbourList(float radius, size_t particleCount, float skin = 0.0f, size_t expectedNeighbours = 64);
+
+    // sizes offsets, indices and the reference positions for capacity particles,
+    // only a store denser than expectedNeighbours per particle grows indices later
+    void reserve(size_t capacity);
+
+    // allowReorder = false keeps the particle order, for solvers that rebuild on
+    // predicted positions while holding per particle state
+    template <typename Real>
+    bool update(BasicParticleSystem<Real> &particles, UniformGrid &grid, ThreadPool &pool, bool allowReorder = true);
+
+    // forces the next update() to rebuild, for when particles were added or removed
+    void invalidate() { this->refX.clear(); }
+
+    template <typename Real>
+    void build(const BasicParticleSystem<Real> &particles, const UniformGrid &grid, ThreadPool &pool);
+
+    // lists the particles of another store (binned in grid) around each particle
+    template <typename Real>
+    void build(const BasicParticleSystem<Real> &particles, const BasicParticleSystem<Real> &sources, const UniformGrid &grid, ThreadPool &pool);
+
+    float rebuildRate() const { return this->updates > 0 ? (float)this->rebuilds / this->updates : 0.0f; }
+
+    uint32_t count(size_t i) const { return this->offsets[i + 1] - this->offsets[i]; }
+    const uint32_t* begin(size_t i) const { return this->indices.data() + this->offsets[i]; }
+    const uint32_t* end(size_t i) const { return this->indices.data() + this->offsets[i + 1]; }
+
+private:
+    // positions at the last build, they only have to resolve half the skin so
+    // float does for either store
+    AlignedVector<float> refX, refY, refZ;
+
+    template <typename Real>
+    bool needsRebuild(const BasicParticleSystem<Real> &particles, ThreadPool &pool) const;
+
+    template <typename Real, typename F>
+    void forEachNeighbour(const BasicParticleSystem<Real> &particles, const BasicParticleSystem<Real> &sources, const UniformGrid &grid, size_t i, F f) const;
+};
+
+#endif
@@ -3,40 +3,37 @@
 
 #include "glm/fwd.hpp"
 #include "glm/glm.hpp"
+#include "particle_system.hpp"
+#include "neighbour_list.hpp"
 
 #include <vector>
-#include <unordered_map>
 
+// lightweight handle onto one entry of a ParticleSystem, keeps the old
+// per-particle API while the data itself lives in the SoA columns.
+// handles are plain indices, call remap() after the store has been reordered
 class Particle {
 public:
-    glm::mat4 model;
+    Particle(ParticleSystem &system, uint32_t index);
 
-    glm::vec3 position;
-    glm::vec3 velocity;
-    glm::vec3 acceleration;
-    glm::vec3 force;
+    uint32_t index;
 
-    glm::ivec3 cell;
-    uint hash;
+    glm::vec3 position() const;
+    glm::vec3 velocity() const;
+    glm::mat4 model() const;
 
-    float density;
-    float pressure;
+    uint hash() const;
 
-    std::vector<Particle*> neighbours;
+    float density() const;
+    float pressure() const;
 
-    Particle(glm::vec3 position, glm::mat4 model);
-
-    void calcCell();
-    void calcHash();
-
-    uint cellHash(const glm::ivec3 &cell);
+    void remap();
 
     glm::mat4 updatePhysics(float deltaTime);
 
-    static void sortParticles(std::vector<Particle*> particles);
-    static std::unordered_map<uint32_t, uint32_t> neighbourTable(std::vector<Particle*> sortedParticles);
+    std::vector<Particle> getNeighbours(const NeighbourList &neighbours) const;
 
-    void getNeighbours(std::vector<Particle*> sortedParticles, std::unordered_map<uint32_t, uint32_t>& neighbourTable);
+private:
+    ParticleSystem *system;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,105 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include "aligned_allocator.hpp"
+#include "glm/glm.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// structure-of-arrays particle store, every per-particle attribute lives in its
+// own contiguous column so the simulation passes stream linearly through memory.
+// Real is float or double, both are instantiated in particle_system.cpp.
+// the renderer and the iterative solvers only run on the float store, WCSPH
+// and BasicSimulation run on either (bench/real_benchmark.cpp compares them)
+template <typename Real>
+class BasicParticleSystem {
+public:
+    using Vec3 = glm::vec<3, Real>;
+
+    AlignedVector<Real> px, py, pz;
+    AlignedVector<Real> vx, vy, vz;
+    AlignedVector<Real> ax, ay, az;
+
+    // positions before the last fixed step, rendering interpolates from them
+    AlignedVector<Real> prevX, prevY, prevZ;
+
+    // accelerations of the last step, kept for integrators that need them
+    AlignedVector<Real> prevAx, prevAy, prevAz;
+
+    AlignedVector<Real> density;
+    AlignedVector<Real> pressure;
+
+    // DFSPH stiffness of the last step, kept per particle for warm starting
+    AlignedVector<Real> stiffness;
+    AlignedVector<Real> divergenceStiffness;
+
+    // mass relative to a particle of the base resolution and the matching
+    // kernel support scale cbrt(mass), both 1 unless adaptive resolution split
+    // or merged the particle
+    AlignedVector<Real> mass;
+    AlignedVector<Real> smoothing;
+
+    AlignedVector<uint32_t> hash;
+
+    // true while some particle is not of the base size, the kernel loops then
+    // take the per-pair support and the masses into account
+    bool mixedSizes = false;
+
+    // vertical acceleration and the half width of the box the particles live
+    // in, [-boxSize, boxSize] x [0, ...) x [-boxSize, boxSize]
+    Real gravity;
+    Real boxSize;
+
+    BasicParticleSystem();
+
+    void reserve(size_t count);
+    void clear();
+
+    size_t size() const { return this->px.size(); }
+
+    size_t add(Vec3 position, Vec3 velocity = Vec3(0), Real mass = 1);
+
+    Vec3 position(size_t i) const { return Vec3(this->px[i], this->py[i], this->pz[i]); }
+    Vec3 velocity(size_t i) const { return Vec3(this->vx[i], this->vy[i], this->vz[i]); }
+
+    void setPosition(size_t i, Vec3 position);
+    void setVelocity(size_t i, Vec3 velocity);
+
+    // order may be shorter than the store, the particles it leaves out are dropped
+    void permute(const std::vector<uint32_t> &order);
+    uint32_t remapped(uint32_t oldIndex) const { return this->newIndex[oldIndex]; }
+
+    void integrate(Real deltaTime, ThreadPool &pool);
+    void integrate(size_t begin, size_t end, Real deltaTime);
+
+    // advances positions and velocities with the scheme from integrators.hpp and
+    // resolves the box walls. instantiated for the three schemes there
+    template <typename Integrator>
+    void integrate(size_t begin, size_t end, Real deltaTime, Real previousDeltaTime);
+
+    void savePositions(ThreadPool &pool);
+
+    // matrices are float whatever Real is, they only feed the renderer
+    glm::mat4 model(size_t i) const;
+    glm::mat4 model(size_t i, float alpha) const;
+
+    // alpha blends from the saved positions (0) to the current ones (1)
+    void fillModelMatrices(std::vector<glm::mat4> &modelMatrices, ThreadPool &pool, float alpha = 1.0f) const;
+
+private:
+    AlignedVector<Real> scratch;
+    AlignedVector<uint32_t> scratchIndex;
+
+    // old index -> new index of the last permute()
+    std::vector<uint32_t> newIndex;
+
+    template <typename T>
+    void gather(AlignedVector<T> &column, AlignedVector<T> &scratch, const std::vector<uint32_t> &order);
+};
+
+using ParticleSystem = BasicParticleSystem<float>;
+
+#endif
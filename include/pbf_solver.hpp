@@ -0,0 +1,55 @@
+#ifndef PBF_SOLVER_H
+#define PBF_SOLVER_H
+
+#include "aligned_allocator.hpp"
+#include "solver.hpp"
+
+// position based fluids (Macklin and Mueller 2013). positions are predicted
+// with gravity and viscosity, then a fixed number of Jacobi sweeps project
+// them onto the density constraints rho_i / rho_0 - 1 = 0. the artificial
+// pressure term s_corr keeps the surface from clustering. the projected
+// motion is handed to the integrator as an acceleration, so it lands every
+// particle exactly on its projected position
+class PbfSolver : public Solver {
+public:
+    unsigned int constraintIterations;
+
+    // constraint force mixing epsilon, relative to the lattice gradient term
+    float relaxation;
+
+    // s_corr = -k (W(r) / W(dq))^n
+    float correctionK;
+    unsigned int correctionN;
+    float correctionDq;
+
+    // average relative compression left after the last step
+    float densityError;
+
+    PbfSolver(float smoothingRadius, float spacing);
+
+    Solver_Type type() const override { return PBF; }
+    const char* name() const override { return "PBF"; }
+    bool requiresEuler() const override { return true; }
+
+    void step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) override;
+    void reserve(size_t capacity) override { this->resize(capacity); }
+
+private:
+    // sum_k |grad_k C_i|^2 for a particle inside a filled lattice
+    float gradientTerm;
+
+    AlignedVector<float> x0, y0, z0;
+    AlignedVector<float> lambda;
+    AlignedVector<float> dx, dy, dz;
+
+    // sum_b psi_b grad W_ib at the predicted positions of the current sweep
+    AlignedVector<float> gbx, gby, gbz;
+
+    void resize(size_t n);
+
+    template <typename Kernel>
+    void step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+              float deltaTime);
+};
+
+#endif
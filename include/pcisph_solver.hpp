@@ -0,0 +1,47 @@
+#ifndef PCISPH_SOLVER_H
+#define PCISPH_SOLVER_H
+
+#include "aligned_allocator.hpp"
+#include "solver.hpp"
+
+// predictive-corrective incompressible SPH (Solenthaler and Pajarola 2009).
+// pressures are corrected from the predicted density error until it drops
+// below tolerance. the iterations reuse the neighbour lists of the frame until
+// the predicted positions leave their skin, then the lists are rebuilt on them
+class PcisphSolver : public Solver {
+public:
+    float tolerance;
+    unsigned int minIterations;
+    unsigned int maxIterations;
+
+    // largest relative density error left after the last step
+    float densityError;
+
+    PcisphSolver(float smoothingRadius, float spacing);
+
+    Solver_Type type() const override { return PCISPH; }
+    const char* name() const override { return "PCISPH"; }
+
+    // the single precomputed delta only fits the base lattice, scaling it per
+    // particle still lets split regions diverge
+    bool mixedSizes() const override { return false; }
+
+    void step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) override;
+    void reserve(size_t capacity) override { this->resize(capacity); }
+
+private:
+    // sum_j grad W . grad W + |sum_j grad W|^2 over a filled lattice neighbourhood
+    float gradientTerm;
+
+    AlignedVector<float> x0, y0, z0;
+    AlignedVector<float> anx, any, anz;
+    AlignedVector<float> apx, apy, apz;
+
+    void resize(size_t n);
+
+    template <typename Kernel>
+    void step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+              float deltaTime);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "glm/glm.hpp"
+#include "particle_system.hpp"
+#include "solver.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// count.x * count.y * count.z particles on the lattice of the scenario spacing,
+// the first one at origin
+struct ParticleBlock {
+    glm::vec3 origin;
+    glm::uvec3 count;
+    glm::vec3 velocity;
+};
+
+// the setup of a run, read at startup from an ini file of sections and
+// key = value lines, # and ; start comments. vectors are three numbers
+//
+//   [domain]    box_size, spacing, smoothing_radius, gravity
+//   [block]     origin, count, velocity, one section per block
+//   [solver]    type (wcsph, pcisph, dfsph, iisph or pbf), viscosity,
+//               sound_speed, fixed_step, max_frame_steps
+//   [threads]   count (0 is every hardware thread), chunk_size
+//   [adaptive]  enabled, max_particles (0 is ADAPTIVE_MAX_FACTOR times the blocks)
+//   [sleeping]  enabled
+//   [collider]  enabled
+//
+// whatever the file leaves out keeps the defaults of constants.hpp, the
+// smoothing radius follows the spacing unless it is given. the skin, the
+// boundary and collider geometry and the particle radius are derived from
+// the spacing, the radius and the box with the *_FACTOR constants.
+//
+// capacity() is the most particles the run will ever hold, the particle
+// columns, neighbour lists, boundary lists and instance buffers are sized to
+// it once so none of them regrows mid-run
+class Scenario {
+public:
+    float boxSize;
+    float spacing;
+    float smoothingRadius;
+    float gravity;
+
+    std::vector<ParticleBlock> blocks;
+
+    Solver_Type solver;
+    float viscosity;
+    float soundSpeed;
+    float fixedStep;
+    unsigned int maxFrameSteps;
+
+    unsigned int threadCount;
+    size_t chunkSize;
+
+    bool adaptive;
+    size_t maxParticles;
+
+    bool sleeping;
+    bool collider;
+
+    // the compiled in dam break, one PARTICLE_ROW_COUNT^3 block
+    Scenario();
+
+    // reads path over the current values. on a missing file, an unknown key or
+    // a value that does not parse it prints where and returns false
+    bool load(const std::string &path);
+
+    size_t particleCount() const;
+    size_t capacity() const;
+
+    float verletSkin() const;
+    float particleRadius() const;
+    float boundaryOffset() const;
+
+    // the blocks, reserved for capacity(). instantiated for float and double stores
+    template <typename Real>
+    BasicParticleSystem<Real> createParticles() const;
+
+private:
+    bool validate(const std::string &path) const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SDF_COLLIDER_H
+#define SDF_COLLIDER_H
+
+#include "aligned_allocator.hpp"
+#include "glm/glm.hpp"
+#include "particle_system.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// static collider stored as a narrow band signed distance field on a regular
+// grid of nodes, negative inside the mesh. the mesh (a closed triangle soup
+// with three corners per triangle, see Model::triangles) is voxelized once:
+// exact point-triangle distances are only computed within band of the
+// surface, nodes further away keep +-band. the sign comes from the parity of
+// ray crossings along x, so it does not depend on the winding of the mesh.
+//
+// the triangles are bucketed by z slice and every slice is voxelized by one
+// task, a task only writes the nodes of its own slice. with a cache path the
+// field is read back from disk when the file was written for the same
+// triangles, cell size and band, and written there otherwise
+class SdfCollider {
+public:
+    float cellSize;
+    float band;
+
+    glm::vec3 origin;
+    glm::ivec3 dims;
+
+    AlignedVector<float> phi;
+
+    // true when the field came from the cache file
+    bool cached;
+
+    SdfCollider(const std::vector<glm::vec3> &triangles, float cellSize, float band, ThreadPool &pool, const std::string &cachePath = "");
+
+    // trilinear lookup, +band outside the grid
+    float distance(glm::vec3 position) const;
+
+    // central differences of distance(), not normalized
+    glm::vec3 gradient(glm::vec3 position) const;
+
+    // pushes the particles of [begin, end) closer than radius back onto the
+    // surface and removes the velocity into it. instantiated for float and
+    // double stores, the field is float either way
+    template <typename Real>
+    void collide(BasicParticleSystem<Real> &particles, size_t begin, size_t end, float radius) const;
+
+private:
+    uint64_t key;
+
+    float node(int x, int y, int z) const;
+
+    void voxelize(const std::vector<glm::vec3> &triangles, ThreadPool &pool);
+
+    bool load(const std::string &path);
+    void save(const std::string &path) const;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include "glm/glm.hpp"
+#include "particle_system.hpp"
+#include "sph_kernels.hpp"
+
+#include <cstdint>
+
+enum Simd_Level {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+template <typename Real>
+struct BasicForceSums {
+    glm::vec<3, Real> pressure;
+    glm::vec<3, Real> viscosity;
+};
+
+using ForceSums = BasicForceSums<float>;
+
+// neighbour loops of the SPH solvers, evaluated 8 (AVX2) or 16 (AVX-512)
+// neighbours at a time straight from the SoA columns with gathered loads and
+// a masked tail. the scalar path is the reference the vector ones are checked
+// against (bench/simd_check.cpp, make check) and the fallback on cpus without
+// AVX2. the instruction set is picked at run time so the binary needs no -m
+// flags. while the store mixes particle sizes a scalar path weights every term
+// by m_j (relative to the base mass) and evaluates it with the pair support
+// (s_i + s_j) h / 2.
+//
+// the force loop can also read its neighbours from a packed fp16 record of
+// PACKED_WORDS words per particle: (v_x, v_y), (v_z, p / rho^2), (1 / rho, 0).
+// one 12 byte record in place of five scattered floats cuts the gathered
+// bytes per neighbour from 32 to 24 and the touched cache lines from eight to
+// four. the halves are widened with F16C, all arithmetic stays in fp32 and
+// particle i itself is read at full precision. the records are rewritten
+// every step from the fp32 columns, which stay the only particle state.
+//
+// every loop is a template on the kernel type, instantiated for SphKernel and
+// for DefaultSphKernel whose h, h^2 and coefficients are compile time constants,
+// and for their double counterparts. the store is of the kernel's scalar type,
+// a double store always takes the scalar paths
+template <typename Kernel>
+class BasicSimdKernels {
+public:
+    using Real = typename Kernel::Scalar;
+
+    static const size_t PACKED_WORDS = 3;
+
+    // the requested level is lowered to what the cpu supports
+    BasicSimdKernels(Simd_Level level = AVX512);
+
+    static Simd_Level detect();
+
+    Simd_Level level() const { return this->simdLevel; }
+
+    // sum_j W_poly6(|x_i - x_j|)
+    Real densitySum(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, const uint32_t *neighbours, uint32_t count) const;
+
+    // pressure:  sum_j (p_i / rho_i^2 + p_j / rho_j^2) grad W_spiky(x_i - x_j)
+    // viscosity: sum_j (v_j - v_i) / rho_j laplacian W_viscosity(|x_i - x_j|)
+    BasicForceSums<Real> forceSums(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, const uint32_t *neighbours, uint32_t count) const;
+
+    // writes the records of [begin, end) into packed, which holds PACKED_WORDS words per particle
+    void pack(const BasicParticleSystem<Real> &particles, size_t begin, size_t end, uint32_t *packed) const;
+
+    // forceSums with the neighbours read from records pack() wrote this step
+    BasicForceSums<Real> forceSums(const Kernel &kernel, const BasicParticleSystem<Real> &particles, const uint32_t *packed, size_t i, const uint32_t *neighbours,
+                                   uint32_t count) const;
+
+private:
+    Simd_Level simdLevel;
+
+    Real (*density)(const Kernel&, const BasicParticleSystem<Real>&, size_t, const uint32_t*, uint32_t);
+    BasicForceSums<Real> (*forces)(const Kernel&, const BasicParticleSystem<Real>&, size_t, const uint32_t*, uint32_t);
+
+    void (*packer)(const BasicParticleSystem<Real>&, size_t, size_t, uint32_t*);
+    BasicForceSums<Real> (*packedForces)(const Kernel&, const BasicParticleSystem<Real>&, const uint32_t*, size_t, const uint32_t*, uint32_t);
+};
+
+using SimdKernels = BasicSimdKernels<SphKernel>;
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "adaptive_resolution.hpp"
+#include "boundary_particles.hpp"
+#include "glm/glm.hpp"
+#include "integrators.hpp"
+#include "neighbour_list.hpp"
+#include "particle_system.hpp"
+#include "scenario.hpp"
+#include "sdf_collider.hpp"
+#include "sleeping_cells.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "timestep_controller.hpp"
+#include "uniform_grid.hpp"
+#include "solver.hpp"
+
+#include <memory>
+#include <vector>
+
+// integration scheme of the particle step, resolved at compile time so it
+// inlines into the integration loop. SemiImplicitEuler, Leapfrog or VelocityVerlet.
+// solvers whose requiresEuler() is set only run under SemiImplicitEuler
+using SimulationIntegrator = SemiImplicitEuler;
+
+// owns the particle store and everything the per-frame step needs. the frame
+// time is scaled and accumulated, then consumed in fixed steps so the cost of
+// a simulated second does not depend on the display rate. a fixed step that
+// the timestep controller finds unsafe is split further, each substep is a
+// task graph built once per solver:
+//
+//   neighbours (fluid and boundary) -> sleeping cells -> solver passes -> integrate[c]
+//
+// where [c] are fixed chunks of the particle range and integrate[c] also
+// pushes its chunk out of the SDF colliders. particles of sleeping cells are
+// skipped by integration and by the WCSPH force pass. WCSPH spreads its passes
+// over the same chunks, the iterative solvers run as one node that splits
+// each iteration across the pool itself. the model matrices are filled once
+// per frame, interpolated between the last two fixed steps by the time left
+// in the accumulator. adaptive resolution runs between fixed steps of solvers
+// that handle mixed particle sizes, when it splits or merges particles the
+// lists are rebuilt and so is the graph.
+//
+// everything is set up from a Scenario, the buffers that follow the particle
+// count are allocated for its capacity() once.
+//
+// Real is the scalar type of the particle store, instantiated for float and
+// double in simulation.cpp. time, the grid and the colliders stay float. a
+// double store runs WCSPH only, the iterative solvers are float only
+template <typename Real>
+class BasicSimulation {
+public:
+    const Scenario scenario;
+
+    ThreadPool pool;
+
+    BasicParticleSystem<Real> particles;
+    UniformGrid grid;
+    NeighbourList neighbours;
+    BasicBoundaryParticles<Real> boundary;
+    std::vector<SdfCollider> colliders;
+    std::unique_ptr<BasicSolver<Real>> solver;
+    TimestepController timestep;
+    AdaptiveResolution adaptive;
+    SleepingCells sleeping;
+
+    std::vector<glm::mat4> modelMatrices;
+
+    explicit BasicSimulation(const Scenario &scenario);
+
+    float fixedStep;
+    unsigned int maxSteps;
+
+    // simulated seconds per real second
+    float timeScale;
+
+    // fixed steps and graph runs of the last step() call
+    unsigned int steps;
+    unsigned int substeps;
+
+    // fraction of a fixed step the rendered state lies past the previous one
+    float alpha;
+
+    // accumulates frameTime and runs up to maxSteps fixed steps, time beyond
+    // that cap is dropped so a slow frame slows the simulation down
+    void step(float frameTime);
+
+    // one fixed step, split into CFL-limited substeps
+    void advance(float deltaTime);
+
+    // replaces the solver. one that cannot run under SimulationIntegrator, one
+    // without mixedSizes() while the store holds split particles, or one that
+    // does not run on a store of Real, is refused with an error and the
+    // current one kept
+    bool setSolver(Solver_Type type);
+
+private:
+    TaskGraph graph;
+    float deltaTime;
+    float previousDeltaTime;
+    float accumulator;
+
+    void buildGraph();
+    void resized();
+};
+
+using Simulation = BasicSimulation<float>;
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef SLEEPING_CELLS_H
+#define SLEEPING_CELLS_H
+
+#include "aligned_allocator.hpp"
+#include "particle_system.hpp"
+#include "thread_pool.hpp"
+#include "uniform_grid.hpp"
+
+#include <cstdint>
+
+// puts resting fluid to sleep one grid cell at a time. a cell is calm while
+// none of its particles is faster than sleepSpeed and its mean density moves
+// by less than densityChange rho_0 per step, after calmSteps calm steps in a
+// row it falls asleep and its particles are frozen: their velocities are
+// zeroed and the force and integration passes skip them. their densities and
+// pressures are still computed, so fluid pushing into a sleeping cell meets
+// its current pressure and the density change wakes the cell. a cell that is
+// not calm disturbs the 26 cells around it, which wake up and have to stay
+// calm for calmSteps again.
+//
+// the cells are the ones of the dense neighbour grid, whose index of a cell
+// does not change between builds. particles are binned as of the last build,
+// which is at most half a verlet skin off. hashed grids never sleep
+class SleepingCells {
+public:
+    bool enabled;
+
+    float sleepSpeed;
+    float densityChange;
+    unsigned int calmSteps;
+
+    // of the last update
+    size_t sleepingCells;
+    size_t sleepingParticles;
+
+    SleepingCells(float sleepSpeed, float densityChange, unsigned int calmSteps);
+
+    void reserve(size_t capacity) { this->particleAsleep.reserve(capacity); }
+
+    // grid has to be built for the current particle indices, the densities
+    // are the ones of the last solver step. instantiated for float and double stores
+    template <typename Real>
+    void update(BasicParticleSystem<Real> &particles, const UniformGrid &grid, float restDensity, ThreadPool &pool);
+
+    // calls f(runBegin, runEnd) for every run of awake particles in [begin, end).
+    // the store is in z-order, so resting regions are long runs
+    template <typename F>
+    void forEachAwake(size_t begin, size_t end, F f) const;
+
+private:
+    AlignedVector<uint8_t> particleAsleep;
+
+    AlignedVector<float> cellDensity;
+    AlignedVector<uint32_t> cellCalm;
+    AlignedVector<uint8_t> cellRestless;
+    AlignedVector<uint8_t> cellAsleep;
+
+    void reset();
+};
+
+template <typename F>
+void SleepingCells::forEachAwake(size_t begin, size_t end, F f) const {
+    if(!this->enabled || this->sleepingParticles == 0 || end > this->particleAsleep.size()) {
+        f(begin, end);
+        return;
+    }
+
+    const uint8_t *flags = this->particleAsleep.data();
+
+    while(begin < end) {
+        while(begin < end && flags[begin]) begin++;
+
+        size_t run = begin;
+        while(run < end && !flags[run]) run++;
+
+        if(run > begin) f(begin, run);
+        begin = run;
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "boundary_particles.hpp"
+#include "neighbour_list.hpp"
+#include "particle_system.hpp"
+#include "simd_kernels.hpp"
+#include "sleeping_cells.hpp"
+#include "sph_kernels.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+
+enum Solver_Type {
+    WCSPH,
+    PCISPH,
+    DFSPH,
+    IISPH,
+    PBF
+};
+
+// common state and passes of the SPH solvers. a solver turns densities and
+// pressures into the non-gravity accelerations ax/ay/az, the integrator
+// then advances velocities and positions with them.
+//
+// Real is the scalar type of the store, instantiated for float and double in
+// solver.cpp. WCSPH runs on both, the iterative solvers derive from the float
+// Solver only
+template <typename Real>
+class BasicSolver {
+public:
+    using Vec3 = glm::vec<3, Real>;
+
+    BasicSphKernel<Real> kernel;
+    BasicSimdKernels<BasicSphKernel<Real>> simd;
+
+    // set when kernel.h is the compiled in SMOOTHING_RADIUS up to float
+    // rounding, the neighbour loops of every solver then run on
+    // BasicDefaultSphKernel and fixedSimd with every kernel coefficient a constant
+    bool fixedKernel;
+    BasicSimdKernels<BasicDefaultSphKernel<Real>> fixedSimd;
+
+    Real restDensity;
+    Real particleMass;
+    Real viscosity;
+
+    // static wall particles the solver adds to densities and pressure forces, may be null
+    BasicBoundaryParticles<Real> *boundary;
+
+    // grid the neighbour lists are built on, lets the iterative solvers rebuild
+    // them on predicted positions, may be null
+    UniformGrid *grid;
+
+    // resting cells whose particles the per-particle passes may skip, may be null
+    const SleepingCells *sleeping;
+
+    // pressure iterations of the last step and in total, 0 for non-iterative solvers
+    unsigned int iterations;
+    unsigned long totalIterations;
+    unsigned long steps;
+
+    BasicSolver(Real smoothingRadius, Real spacing);
+    virtual ~BasicSolver() = default;
+
+    virtual Solver_Type type() const = 0;
+    virtual const char* name() const = 0;
+
+    virtual void step(BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) = 0;
+
+    // allocates the per-particle scratch of the solver for capacity particles
+    // up front, the columns then only shrink and grow within it
+    virtual void reserve(size_t) {}
+
+    // whether the solver stays stable with split and merged particles of mixed
+    // sizes, adaptive resolution pauses while the solver does not
+    virtual bool mixedSizes() const { return true; }
+
+    // whether the solver turns its velocity changes into accelerations for
+    // SemiImplicitEuler and breaks under any other SimulationIntegrator
+    virtual bool requiresEuler() const { return false; }
+
+    // speed pressure waves travel at, bounds the step of compressible solvers
+    virtual float signalSpeed() const { return 0.0f; }
+
+    // inserts the solver's passes into the frame graph after start and returns
+    // the node integration has to wait for. the default is one node running step()
+    virtual size_t addTasks(TaskGraph &graph, BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, const float &deltaTime,
+                            size_t start);
+
+    // f(runBegin, runEnd) over the awake particles of [begin, end)
+    template <typename F>
+    void forEachAwake(size_t begin, size_t end, F f) const {
+        if(this->sleeping) this->sleeping->forEachAwake(begin, end, f);
+        else f(begin, end);
+    }
+
+    float averageIterations() const { return this->steps > 0 ? (float)this->totalIterations / this->steps : 0.0f; }
+
+    // fluid and boundary contributions
+    void computeDensity(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours, size_t begin, size_t end) const;
+
+    template <typename Kernel>
+    void computeDensity(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, BasicParticleSystem<Real> &particles, const NeighbourList &neighbours,
+                        size_t begin, size_t end) const {
+        Real *density = particles.density.data();
+
+        for(size_t i = begin; i < end; i++) {
+            density[i] = this->particleMass * simd.densitySum(kernel, particles, i, neighbours.begin(i), neighbours.count(i)) + this->boundaryDensity(particles, i);
+        }
+    }
+
+    Real boundaryDensity(const BasicParticleSystem<Real> &particles, size_t i) const;
+    Vec3 boundaryGradient(const BasicParticleSystem<Real> &particles, size_t i) const;
+
+    // -p_i / rho_i^2 sum_b psi_b grad W_ib, the boundary reacts with the fluid particle's own pressure
+    Vec3 boundaryPressureAcceleration(const BasicParticleSystem<Real> &particles, size_t i) const;
+
+    // pair terms of the hand written neighbour loops. with mixed particle sizes
+    // the pair support is (s_i + s_j) h / 2 and particle j weighs m_j times the
+    // base mass, otherwise these reduce to the plain kernel and particleMass
+    Real pairScale(const BasicParticleSystem<Real> &particles, size_t i, size_t j) const {
+        return particles.mixedSizes ? Real(0.5) * (particles.smoothing[i] + particles.smoothing[j]) : Real(1);
+    }
+
+    template <typename Kernel>
+    Vec3 spikyGradient(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, size_t j) const {
+        Vec3 r = particles.position(i) - particles.position(j);
+        return particles.mixedSizes ? kernel.spikyGradient(r, this->pairScale(particles, i, j)) : kernel.spikyGradient(r);
+    }
+
+    Real neighbourMass(const BasicParticleSystem<Real> &particles, size_t j) const { return this->particleMass * particles.mass[j]; }
+
+protected:
+    Real spacing;
+
+    void countIterations(unsigned int iterations);
+
+    // called once predicted positions are in the position columns. the lists
+    // only cover a move of skin / 2 from where they were built, past that they
+    // and the boundary lists are rebuilt on the predicted positions without
+    // reordering the store. returns true if they were
+    bool followPrediction(BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool);
+};
+
+using Solver = BasicSolver<float>;
+
+#endif
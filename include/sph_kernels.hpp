@@ -0,0 +1,133 @@
+#ifndef SPH_KERNELS_H
+#define SPH_KERNELS_H
+
+#include "constants.hpp"
+#include "glm/glm.hpp"
+
+#include <cmath>
+
+// x^N by repeated multiplication, std::pow is not constexpr
+template <int N, typename Real>
+constexpr Real power(Real x) {
+    Real result = 1;
+    for(int i = 0; i < N; i++) result *= x;
+
+    return result;
+}
+
+// smoothing kernels of Mueller et al. 2003 for a support radius h. these are
+// the scalar reference versions, the batched ones in simd_kernels.hpp must
+// agree with them up to rounding. Real is the scalar type of the store the
+// solver runs on, float or double.
+//
+// the terms are written once against h, h2 and the three coefficients of
+// Kernel, which BasicSphKernel holds as members set at run time and
+// FixedSphKernel as constants folded at compile time
+template <typename Kernel, typename Real>
+struct SphKernelTerms {
+    using Scalar = Real;
+    using Vec3 = glm::vec<3, Real>;
+
+    // takes the squared distance so the density loop needs no sqrt
+    constexpr Real poly6(Real r2) const {
+        if(r2 >= self().h2) return 0;
+
+        Real t = self().h2 - r2;
+        return self().poly6Coefficient * t * t * t;
+    }
+
+    // gradient with respect to x_i of W(x_i - x_j), r = x_i - x_j
+    Vec3 spikyGradient(Vec3 r) const {
+        Real length = glm::length(r);
+        if(length >= self().h || length <= 0) return Vec3(0);
+
+        Real t = self().h - length;
+        return self().spikyGradientCoefficient * t * t / length * r;
+    }
+
+    constexpr Real viscosityLaplacian(Real r) const {
+        if(r >= self().h) return 0;
+
+        return self().viscosityLaplacianCoefficient * (self().h - r);
+    }
+
+    // the same kernels with the support scaled to s h, W_sh(r) = W_h(r / s) / s^3.
+    // particles of mixed size use s = (s_i + s_j) / 2 so every pair stays symmetric
+    constexpr Real poly6(Real r2, Real s) const {
+        return this->poly6(r2 / (s * s)) / (s * s * s);
+    }
+
+    Vec3 spikyGradient(Vec3 r, Real s) const {
+        Real s2 = s * s;
+        return this->spikyGradient(r / s) / (s2 * s2);
+    }
+
+    constexpr Real viscosityLaplacian(Real r, Real s) const {
+        Real s2 = s * s;
+        return this->viscosityLaplacian(r / s) / (s2 * s2 * s);
+    }
+
+    // mass that gives a particle inside a cubic lattice of the given spacing exactly the rest density
+    Real latticeMass(Real spacing, Real restDensity) const {
+        int reach = (int)std::ceil(self().h / spacing);
+
+        Real sum = 0;
+        for(int x = -reach; x <= reach; x++) {
+            for(int y = -reach; y <= reach; y++) {
+                for(int z = -reach; z <= reach; z++) {
+                    Vec3 r = spacing * Vec3(x, y, z);
+                    sum += this->poly6(glm::dot(r, r));
+                }
+            }
+        }
+
+        return restDensity / sum;
+    }
+
+private:
+    constexpr const Kernel& self() const { return static_cast<const Kernel&>(*this); }
+};
+
+template <typename Real>
+struct BasicSphKernel : SphKernelTerms<BasicSphKernel<Real>, Real> {
+    Real h;
+    Real h2;
+
+    Real poly6Coefficient;
+    Real spikyGradientCoefficient;
+    Real viscosityLaplacianCoefficient;
+
+    constexpr explicit BasicSphKernel(Real h)
+    : h(h), h2(h * h),
+      poly6Coefficient(Real(315) / (Real(64) * Real(M_PI) * power<9>(h))),
+      spikyGradientCoefficient(Real(-45) / (Real(M_PI) * power<6>(h))),
+      viscosityLaplacianCoefficient(Real(45) / (Real(M_PI) * power<6>(h))) {}
+};
+
+// the support radius as a type, Radius::value has to be a constant expression.
+// every coefficient is a compile time constant, so the neighbour loops
+// instantiated for this kernel fold them into immediates
+template <typename Real, typename Radius>
+struct FixedSphKernel : SphKernelTerms<FixedSphKernel<Real, Radius>, Real> {
+    static constexpr Real h = Radius::value;
+    static constexpr Real h2 = h * h;
+
+    static constexpr Real poly6Coefficient = Real(315) / (Real(64) * Real(M_PI) * power<9>(h));
+    static constexpr Real spikyGradientCoefficient = Real(-45) / (Real(M_PI) * power<6>(h));
+    static constexpr Real viscosityLaplacianCoefficient = Real(45) / (Real(M_PI) * power<6>(h));
+};
+
+struct DefaultSmoothingRadius {
+    static constexpr float value = SMOOTHING_RADIUS;
+};
+
+using SphKernel = BasicSphKernel<float>;
+
+// the kernel of the compiled in SMOOTHING_RADIUS, solvers built for that
+// radius run their neighbour loops on it
+template <typename Real>
+using BasicDefaultSphKernel = FixedSphKernel<Real, DefaultSmoothingRadius>;
+
+using DefaultSphKernel = BasicDefaultSphKernel<float>;
+
+#endif
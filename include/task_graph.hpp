@@ -0,0 +1,45 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// static dependency graph of tasks, built once and executed every frame on a
+// ThreadPool. a task is submitted as soon as its last predecessor finishes,
+// onto the queue of the thread that finished it, so follow-up work on the
+// same chunk of particles tends to stay on the same core
+class TaskGraph {
+public:
+    size_t add(std::function<void()> work);
+
+    // after does not start before before has finished
+    void precede(size_t before, size_t after);
+
+    void run(ThreadPool &pool);
+    void clear() { this->nodes.clear(); }
+
+    size_t size() const { return this->nodes.size(); }
+
+private:
+    struct Node {
+        std::function<void()> work;
+        std::vector<size_t> successors;
+        size_t dependencies = 0;
+        std::atomic<size_t> pending;
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes;
+
+    ThreadPool *pool = nullptr;
+    std::atomic<size_t> remaining;
+
+    static void runNode(void *context, size_t index, size_t);
+
+    void submit(size_t index);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work stealing thread pool. every thread owns a bounded deque of tasks, it
+// pops its own newest task first and steals the oldest task of another
+// thread when it runs dry. threads waiting on a result keep executing tasks,
+// so parallel loops and task graphs can nest freely.
+//
+// slot 0 belongs to whichever thread drives the pool from outside, which is
+// expected to be a single thread (the render loop)
+class ThreadPool {
+public:
+    struct Task {
+        void (*run)(void *context, size_t begin, size_t end);
+        void *context;
+        size_t begin;
+        size_t end;
+        std::atomic<size_t> *pending;
+    };
+
+    size_t chunkSize;
+
+    // threadCount 0 uses every hardware thread
+    ThreadPool(unsigned int threadCount = 0, size_t chunkSize = 256);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return this->queues.size(); }
+
+    // the caller has already counted the task into *task.pending, which is
+    // decremented once the task has run
+    void submit(const Task &task);
+    void wait(std::atomic<size_t> &pending);
+
+    // body(begin, end) is called once for every chunk of [begin, end)
+    void parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &body, size_t chunkSize = 0);
+
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(size_t begin, size_t end, T identity, Map map, Combine combine, size_t chunkSize = 0);
+
+private:
+    static const size_t QUEUE_CAPACITY = 4096;
+
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Task> ring;
+        size_t head = 0;
+        size_t count = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Queue> queues;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued;
+    bool stopping;
+
+    void workerLoop(unsigned int index);
+
+    bool push(unsigned int index, const Task &task);
+    bool pop(unsigned int index, Task &task);
+    bool steal(unsigned int index, Task &task);
+    bool tryRunOne(unsigned int index);
+
+    static void execute(const Task &task);
+};
+
+// map(begin, end) reduces one chunk, combine merges two partial results
+template <typename T, typename Map, typename Combine>
+T ThreadPool::parallelReduce(size_t begin, size_t end, T identity, Map map, Combine combine, size_t chunkSize) {
+    T result = identity;
+    std::mutex resultMutex;
+
+    this->parallelFor(begin, end, [&](size_t b, size_t e) {
+        T partial = map(b, e);
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result = combine(result, partial);
+    }, chunkSize);
+
+    return result;
+}
+
+#endif
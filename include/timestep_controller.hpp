@@ -0,0 +1,38 @@
+#ifndef TIMESTEP_CONTROLLER_H
+#define TIMESTEP_CONTROLLER_H
+
+#include "particle_system.hpp"
+#include "thread_pool.hpp"
+
+// picks the simulation step from the CFL condition
+//
+//   dt <= cflFactor * h / (signal speed + max |v|)
+//   dt <= forceFactor * sqrt(h / max |a|)
+//
+// clamped to [minStep, maxStep]. the maxima come from one parallel reduction
+// over the particle store, the accelerations are the ones the solver left in
+// ax/ay/az on the previous step plus gravity. h is the support of the
+// smallest particle when adaptive resolution has split some
+class TimestepController {
+public:
+    float smoothingRadius;
+
+    float cflFactor;
+    float forceFactor;
+    float minStep;
+    float maxStep;
+
+    // inputs and result of the last next() call
+    float maxSpeed;
+    float maxAcceleration;
+    float step;
+
+    TimestepController(float smoothingRadius, float cflFactor, float forceFactor, float minStep, float maxStep);
+
+    // signalSpeed is the solver's pressure wave speed, 0 for incompressible ones.
+    // instantiated for float and double stores, the step itself stays float
+    template <typename Real>
+    float next(const BasicParticleSystem<Real> &particles, ThreadPool &pool, float signalSpeed);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef UNIFORM_GRID_H
+#define UNIFORM_GRID_H
+
+#include "aligned_allocator.hpp"
+#include "glm/glm.hpp"
+#include "particle_system.hpp"
+
+#include <cstdint>
+#include <vector>
+
+enum Grid_Mode {
+    DENSE,
+    HASHED
+};
+
+// uniform grid for neighbour search. build() bins the particles into cells
+// with a counting sort, the particles of cell c are then
+// particleIndex[cellStart[c]] .. particleIndex[cellEnd[c] - 1].
+//
+// every reorderInterval builds the particle store itself is permuted into
+// z-order (morton code of the cell) so spatially close particles also sit
+// close in memory. build() returns true on those frames, anything holding
+// particle indices has to remap them through ParticleSystem::remapped. a build
+// in the middle of a step passes allowReorder = false and keeps the indices.
+//
+// a bounded domain uses a dense x + y*nx + z*nx*ny cell index, positions
+// outside the box are clamped into the border cells. an unbounded domain
+// falls back to an open addressing hash table keyed on the full cell
+// coordinate, so two cells never share an entry. its tables are sized for the
+// particle count it was made for and regrow in build() when the store outgrows it.
+//
+// the entry points are templated on the scalar type of the store and
+// instantiated for float and double, the grid itself keeps float geometry
+class UniformGrid {
+public:
+    static const uint32_t EMPTY = 0xffffffffu;
+
+    Grid_Mode mode;
+    float cellSize;
+
+    glm::vec3 origin;
+    glm::ivec3 dims;
+
+    unsigned int reorderInterval;
+
+    AlignedVector<uint32_t> cellStart;
+    AlignedVector<uint32_t> cellEnd;
+    AlignedVector<uint32_t> particleIndex;
+
+    UniformGrid(float cellSize, glm::vec3 domainMin, glm::vec3 domainMax);
+    UniformGrid(float cellSize, size_t particleCount);
+
+    // sizes the per-particle buffers (and the hashed tables) for capacity
+    // particles so builds and reorders within it never allocate
+    void reserve(size_t capacity);
+
+    template <typename Real>
+    bool build(BasicParticleSystem<Real> &particles, ThreadPool &pool, bool allowReorder = true);
+
+    template <typename Real>
+    void reorder(BasicParticleSystem<Real> &particles, ThreadPool &pool);
+
+    template <typename Real>
+    glm::ivec3 cellCoord(glm::vec<3, Real> position) const;
+    uint32_t cellIndex(const glm::ivec3 &cell) const;
+
+    size_t cellCount() const { return this->activeCells; }
+
+private:
+    size_t activeCells;
+
+    // hashed mode only
+    uint32_t tableMask;
+    uint32_t generation;
+    AlignedVector<glm::ivec3> slotKey;
+    AlignedVector<uint32_t> slotCell;
+    AlignedVector<uint32_t> slotGeneration;
+
+    unsigned int buildCount;
+
+    std::vector<uint64_t> mortonKeys;
+    std::vector<uint32_t> order;
+
+    static uint32_t spreadBits(uint32_t v);
+    uint32_t mortonCode(const glm::ivec3 &cell) const;
+
+    void reserveTable(size_t particleCount);
+    uint32_t slotOf(const glm::ivec3 &cell) const;
+    uint32_t insertCell(const glm::ivec3 &cell);
+};
+
+#endif
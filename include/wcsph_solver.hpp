@@ -0,0 +1,70 @@
+#ifndef WCSPH_SOLVER_H
+#define WCSPH_SOLVER_H
+
+#include "constants.hpp"
+#include "solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Tait equation, negative pressures are clamped so the free surface does not clump
+template <typename Real>
+inline Real taitPressure(Real density, Real restDensity, Real stiffness, Real exponent) {
+    Real ratio = density / restDensity;
+
+    // gamma = 7 is the usual choice, spelled out it avoids a pow per particle
+    Real p;
+    if(exponent == Real(7)) {
+        Real ratio2 = ratio * ratio;
+        p = ratio2 * ratio2 * ratio2 * ratio;
+    } else {
+        p = std::pow(ratio, exponent);
+    }
+
+    return std::max(Real(0), stiffness * (p - Real(1)));
+}
+
+// weakly compressible SPH: density by summation, pressure from the Tait
+// equation and symmetric pressure plus viscosity accelerations. every pass
+// works on a particle range so the task graph can run them chunk by chunk.
+// instantiated for float and double stores in wcsph_solver.cpp
+template <typename Real>
+class BasicWcsphSolver : public BasicSolver<Real> {
+public:
+    Real stiffness;
+    Real exponent;
+
+    // the force pass reads neighbours from fp16 records packed after the
+    // pressure pass, see SimdKernels. the records are a copy next to the fp32
+    // columns, PACKED_WORDS * 4 bytes more per particle, the store is unchanged.
+    // a double store never packs, fp16 neighbours would defeat the precision
+    bool packedForces;
+
+    BasicWcsphSolver(Real smoothingRadius, Real spacing, Real soundSpeed = SOUND_SPEED);
+
+    Solver_Type type() const override { return WCSPH; }
+    const char* name() const override { return "WCSPH"; }
+
+    void step(BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) override;
+    void reserve(size_t capacity) override { this->packed.reserve(SimdKernels::PACKED_WORDS * capacity); }
+    float signalSpeed() const override { return (float)std::sqrt(this->stiffness * this->exponent / this->restDensity); }
+    size_t addTasks(TaskGraph &graph, BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, const float &deltaTime,
+                    size_t start) override;
+
+    void computePressure(BasicParticleSystem<Real> &particles, size_t begin, size_t end) const;
+    void computeForces(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours, size_t begin, size_t end) const;
+
+    // packs the records of [begin, end) when packedForces
+    void pack(const BasicParticleSystem<Real> &particles, size_t begin, size_t end);
+
+private:
+    AlignedVector<uint32_t> packed;
+
+    template <typename Kernel>
+    void computeForces(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, BasicParticleSystem<Real> &particles, const NeighbourList &neighbours,
+                       size_t begin, size_t end) const;
+};
+
+using WcsphSolver = BasicWcsphSolver<float>;
+
+#endif
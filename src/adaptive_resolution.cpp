@@ -0,0 +1,296 @@
+#include "../include/adaptive_resolution.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// the three axes, the six face diagonals and the four space diagonals, a
+// split only needs one of each opposite pair
+const float D2 = 0.70710678f;
+const float D3 = 0.57735027f;
+
+const glm::vec3 SPLIT_DIRECTIONS[] = {
+    glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+    glm::vec3(D2, D2, 0.0f), glm::vec3(D2, -D2, 0.0f), glm::vec3(D2, 0.0f, D2),
+    glm::vec3(D2, 0.0f, -D2), glm::vec3(0.0f, D2, D2), glm::vec3(0.0f, D2, -D2),
+    glm::vec3(D3, D3, D3), glm::vec3(D3, D3, -D3), glm::vec3(D3, -D3, D3), glm::vec3(-D3, D3, D3)
+};
+
+}
+
+AdaptiveResolution::AdaptiveResolution(float smoothingRadius, float spacing, float minMass, size_t maxParticles, float surfaceDensity, float interiorDensity, float calmSpeed,
+                                       float focusRadius, unsigned int interval)
+: enabled(false),
+  kernel(smoothingRadius),
+  spacing(spacing),
+  minMass(minMass),
+  maxParticles(maxParticles),
+  surfaceDensity(surfaceDensity),
+  interiorDensity(interiorDensity),
+  calmSpeed(calmSpeed),
+  focus(0.0f),
+  focusRadius(focusRadius),
+  interval(interval),
+  relaxIterations(ADAPTIVE_RELAX_ITERATIONS),
+  relaxStrength(ADAPTIVE_RELAX_STRENGTH),
+  splits(0),
+  merges(0),
+  counter(0) {}
+
+template <typename Real>
+bool AdaptiveResolution::update(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours, float restDensity, ThreadPool &pool) {
+    this->splits = 0;
+    this->merges = 0;
+
+    if(!this->enabled || ++this->counter < this->interval) return false;
+    this->counter = 0;
+
+    this->classify(particles, restDensity, pool);
+    this->merge(particles, neighbours);
+    this->split(particles, neighbours);
+    this->relax(particles, neighbours);
+
+    if(this->splits == 0 && this->merges == 0) return false;
+
+    if(this->merges > 0) this->compact(particles);
+
+    particles.mixedSizes = false;
+    for(float mass : particles.mass) {
+        if(mass != 1.0f) {
+            particles.mixedSizes = true;
+            break;
+        }
+    }
+
+    return true;
+}
+
+void AdaptiveResolution::reserve(size_t capacity) {
+    this->actions.reserve(capacity);
+    this->children.reserve(capacity);
+    this->order.reserve(capacity);
+}
+
+template <typename Real>
+void AdaptiveResolution::classify(const BasicParticleSystem<Real> &particles, float restDensity, ThreadPool &pool) {
+    const float focusRadius2 = this->focusRadius * this->focusRadius;
+    const float calmSpeed2 = this->calmSpeed * this->calmSpeed;
+
+    this->actions.resize(particles.size());
+
+    pool.parallelFor(0, particles.size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            glm::vec3 offset = glm::vec3(particles.position(i)) - this->focus;
+            glm::vec3 velocity = particles.velocity(i);
+
+            bool visible = glm::dot(offset, offset) < focusRadius2;
+            float ratio = particles.density[i] / restDensity;
+            float mass = particles.mass[i];
+
+            Action action = KEEP;
+
+            if((visible || ratio < this->surfaceDensity) && 0.5f * mass >= this->minMass) {
+                action = SPLIT;
+            } else if(!visible && ratio > this->interiorDensity && glm::dot(velocity, velocity) < calmSpeed2 && 2.0f * mass <= 1.0f) {
+                action = MERGE;
+            }
+
+            this->actions[i] = action;
+        }
+    });
+}
+
+// greedy pairing, every candidate takes its nearest free neighbour of the same
+// mass that is less than one of its own spacings away and moves with it
+template <typename Real>
+void AdaptiveResolution::merge(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours) {
+    const size_t n = this->actions.size();
+    const float calmSpeed2 = this->calmSpeed * this->calmSpeed;
+
+    for(size_t i = 0; i < n; i++) {
+        if(this->actions[i] != MERGE) continue;
+
+        glm::vec3 xi = particles.position(i);
+        glm::vec3 vi = particles.velocity(i);
+        float mass = particles.mass[i];
+        float reach = this->spacing * particles.smoothing[i];
+
+        uint32_t partner = UINT32_MAX;
+        float nearest2 = reach * reach;
+
+        for(const uint32_t *k = neighbours.begin(i); k != neighbours.end(i); k++) {
+            uint32_t j = *k;
+            if(j == i || this->actions[j] != MERGE || particles.mass[j] != mass) continue;
+
+            glm::vec3 r = xi - glm::vec3(particles.position(j));
+            glm::vec3 dv = vi - glm::vec3(particles.velocity(j));
+            float r2 = glm::dot(r, r);
+
+            if(r2 < nearest2 && glm::dot(dv, dv) < calmSpeed2) {
+                nearest2 = r2;
+                partner = j;
+            }
+        }
+
+        this->actions[i] = KEEP;
+        if(partner == UINT32_MAX) continue;
+
+        uint32_t j = partner;
+
+        // equal masses, so the centre of mass and the mean momentum are plain averages
+        particles.setPosition(i, Real(0.5) * (particles.position(i) + particles.position(j)));
+        particles.setVelocity(i, Real(0.5) * (particles.velocity(i) + particles.velocity(j)));
+
+        particles.prevX[i] = 0.5f * (particles.prevX[i] + particles.prevX[j]);
+        particles.prevY[i] = 0.5f * (particles.prevY[i] + particles.prevY[j]);
+        particles.prevZ[i] = 0.5f * (particles.prevZ[i] + particles.prevZ[j]);
+        particles.prevAx[i] = 0.5f * (particles.prevAx[i] + particles.prevAx[j]);
+        particles.prevAy[i] = 0.5f * (particles.prevAy[i] + particles.prevAy[j]);
+        particles.prevAz[i] = 0.5f * (particles.prevAz[i] + particles.prevAz[j]);
+
+        particles.mass[i] = 2.0f * mass;
+        particles.smoothing[i] = std::cbrt(particles.mass[i]);
+
+        this->actions[j] = REMOVED;
+        this->merges++;
+    }
+}
+
+// the halves go along the candidate direction that keeps them furthest from
+// the particles around, a random one would put some of them right on top of
+// a neighbour and the density spike would blow the pressure solvers up
+template <typename Real>
+void AdaptiveResolution::split(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours) {
+    const size_t n = this->actions.size();
+
+    this->children.assign(n, UINT32_MAX);
+
+    for(size_t i = 0; i < n && particles.size() < this->maxParticles; i++) {
+        if(this->actions[i] != SPLIT) continue;
+
+        float mass = 0.5f * particles.mass[i];
+        float smoothing = std::cbrt(mass);
+        float distance = 0.5f * this->spacing * smoothing;
+
+        glm::vec3 position = particles.position(i);
+        glm::vec3 offset(0.0f);
+        float best = -1.0f;
+
+        for(const glm::vec3 &direction : SPLIT_DIRECTIONS) {
+            glm::vec3 candidate = distance * direction;
+            float nearest2 = INFINITY;
+
+            auto check = [&](uint32_t j) {
+                glm::vec3 r = glm::vec3(particles.position(j)) - position;
+                nearest2 = std::min(nearest2, std::min(glm::dot(r - candidate, r - candidate), glm::dot(r + candidate, r + candidate)));
+            };
+
+            for(const uint32_t *k = neighbours.begin(i); k != neighbours.end(i); k++) {
+                if(*k == i) continue;
+
+                check(*k);
+                if(this->children[*k] != UINT32_MAX) check(this->children[*k]);
+            }
+
+            if(nearest2 > best) {
+                best = nearest2;
+                offset = candidate;
+            }
+        }
+
+        // the halves are placed around the position of the store, only the offset is float
+        const glm::vec<3, Real> centre = particles.position(i);
+        const glm::vec<3, Real> shift(offset);
+
+        size_t j = particles.add(centre + shift, particles.velocity(i), mass);
+        this->children[i] = (uint32_t)j;
+
+        particles.prevX[j] = particles.prevX[i] + shift.x;
+        particles.prevY[j] = particles.prevY[i] + shift.y;
+        particles.prevZ[j] = particles.prevZ[i] + shift.z;
+        particles.prevAx[j] = particles.prevAx[i];
+        particles.prevAy[j] = particles.prevAy[i];
+        particles.prevAz[j] = particles.prevAz[i];
+        particles.density[j] = particles.density[i];
+        particles.pressure[j] = particles.pressure[i];
+        particles.stiffness[j] = particles.stiffness[i];
+        particles.divergenceStiffness[j] = particles.divergenceStiffness[i];
+
+        particles.setPosition(i, centre - shift);
+        particles.prevX[i] -= shift.x;
+        particles.prevY[i] -= shift.y;
+        particles.prevZ[i] -= shift.z;
+
+        particles.mass[i] = mass;
+        particles.smoothing[i] = smoothing;
+
+        this->splits++;
+    }
+}
+
+// particle shifting (Lind et al. 2012) of the split halves, dx = -A h^2 grad C / C
+// with C = sum_b m_b W_ab. the lists of the parents cover the supports of both
+// halves, the halves of split neighbours are reached through children
+template <typename Real>
+void AdaptiveResolution::relax(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours) {
+    const size_t n = this->actions.size();
+
+    for(unsigned int iteration = 0; iteration < this->relaxIterations; iteration++) {
+        for(size_t i = 0; i < n; i++) {
+            if(this->children[i] == UINT32_MAX) continue;
+
+            for(uint32_t a : { (uint32_t)i, this->children[i] }) {
+                glm::vec3 xa = particles.position(a);
+                float sa = particles.smoothing[a];
+
+                float concentration = this->kernel.poly6(0.0f, sa) * particles.mass[a];
+                glm::vec3 gradient(0.0f);
+
+                auto add = [&](uint32_t b) {
+                    if(b == a) return;
+
+                    float s = 0.5f * (sa + particles.smoothing[b]);
+                    glm::vec3 r = xa - glm::vec3(particles.position(b));
+
+                    concentration += particles.mass[b] * this->kernel.poly6(glm::dot(r, r), s);
+                    gradient += (float)particles.mass[b] * this->kernel.spikyGradient(r, s);
+                };
+
+                for(const uint32_t *k = neighbours.begin(i); k != neighbours.end(i); k++) {
+                    add(*k);
+                    if(this->children[*k] != UINT32_MAX) add(this->children[*k]);
+                }
+
+                float h = sa * this->kernel.h;
+                glm::vec3 shift = -this->relaxStrength * h * h * gradient / concentration;
+
+                // never more than a quarter of the particle's own spacing per iteration
+                float limit = 0.25f * this->spacing * sa;
+                float length = glm::length(shift);
+                if(length > limit) shift *= limit / length;
+
+                particles.setPosition(a, particles.position(a) + glm::vec<3, Real>(shift));
+                particles.prevX[a] += shift.x;
+                particles.prevY[a] += shift.y;
+                particles.prevZ[a] += shift.z;
+            }
+        }
+    }
+}
+
+// drops the merged partners, everything else keeps its relative order
+template <typename Real>
+void AdaptiveResolution::compact(BasicParticleSystem<Real> &particles) {
+    this->order.clear();
+
+    for(size_t i = 0; i < particles.size(); i++) {
+        if(i >= this->actions.size() || this->actions[i] != REMOVED) this->order.push_back((uint32_t)i);
+    }
+
+    particles.permute(this->order);
+}
+
+template bool AdaptiveResolution::update(ParticleSystem&, const NeighbourList&, float, ThreadPool&);
+template bool AdaptiveResolution::update(BasicParticleSystem<double>&, const NeighbourList&, float, ThreadPool&);
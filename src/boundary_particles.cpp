@@ -0,0 +1,100 @@
+#include "../include/boundary_particles.hpp"
+
+#include <cmath>
+
+template <typename Real>
+BasicBoundaryParticles<Real>::BasicBoundaryParticles(float spacing, float offset, glm::vec3 boxMin, glm::vec3 boxMax, const BasicSphKernel<Real> &kernel,
+                                                     Real restDensity, float skin, size_t fluidCount, ThreadPool &pool)
+: spacing(spacing),
+  offset(offset),
+  grid(kernel.h + skin, boxMin - glm::vec3(offset + spacing), boxMax + glm::vec3(offset + spacing)),
+  neighbours(kernel.h, fluidCount, skin, 32) {
+    this->sample(boxMin, boxMax);
+
+    // the only build, it also puts the samples into z-order once
+    this->grid.build(this->particles, pool);
+
+    this->computePsi(kernel, restDensity, pool);
+}
+
+template <typename Real>
+void BasicBoundaryParticles<Real>::sample(glm::vec3 boxMin, glm::vec3 boxMax) {
+    glm::vec3 low = boxMin - glm::vec3(this->offset);
+    glm::vec3 high = boxMax + glm::vec3(this->offset);
+
+    int nx = (int)std::round((high.x - low.x) / this->spacing);
+    int ny = (int)std::round((boxMax.y - low.y) / this->spacing);
+    int nz = (int)std::round((high.z - low.z) / this->spacing);
+
+    this->particles.reserve((size_t)(nx + 1) * (nz + 1) + (size_t)2 * (nx + nz) * ny);
+
+    // floor, then the ring of the four walls one layer at a time
+    for(int y = 0; y <= ny; y++) {
+        for(int x = 0; x <= nx; x++) {
+            for(int z = 0; z <= nz; z++) {
+                bool wall = x == 0 || x == nx || z == 0 || z == nz;
+                if(y > 0 && !wall) continue;
+
+                this->particles.add(Vec3(low + this->spacing * glm::vec3(x, y, z)));
+            }
+        }
+    }
+}
+
+template <typename Real>
+void BasicBoundaryParticles<Real>::computePsi(const BasicSphKernel<Real> &kernel, Real restDensity, ThreadPool &pool) {
+    const size_t n = this->size();
+
+    NeighbourList own(kernel.h, n);
+    own.build(this->particles, this->grid, pool);
+
+    this->psi.resize(n);
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t b = begin; b < end; b++) {
+            Vec3 xb = this->particles.position(b);
+            Real sum = 0;
+
+            for(const uint32_t *k = own.begin(b); k != own.end(b); k++) {
+                Vec3 r = xb - this->particles.position(*k);
+                sum += kernel.poly6(glm::dot(r, r));
+            }
+
+            this->psi[b] = restDensity / sum;
+        }
+    });
+}
+
+template <typename Real>
+void BasicBoundaryParticles<Real>::update(const BasicParticleSystem<Real> &fluid, ThreadPool &pool) {
+    this->neighbours.build(fluid, this->particles, this->grid, pool);
+}
+
+template <typename Real>
+Real BasicBoundaryParticles<Real>::density(const BasicSphKernel<Real> &kernel, const BasicParticleSystem<Real> &fluid, size_t i) const {
+    Vec3 xi = fluid.position(i);
+    Real sum = 0;
+
+    for(const uint32_t *b = this->neighbours.begin(i); b != this->neighbours.end(i); b++) {
+        Vec3 r = xi - this->particles.position(*b);
+        sum += this->psi[*b] * kernel.poly6(glm::dot(r, r));
+    }
+
+    return sum;
+}
+
+template <typename Real>
+typename BasicBoundaryParticles<Real>::Vec3 BasicBoundaryParticles<Real>::gradient(const BasicSphKernel<Real> &kernel, const BasicParticleSystem<Real> &fluid,
+                                                                                   size_t i) const {
+    Vec3 xi = fluid.position(i);
+    Vec3 sum(0);
+
+    for(const uint32_t *b = this->neighbours.begin(i); b != this->neighbours.end(i); b++) {
+        sum += this->psi[*b] * kernel.spikyGradient(xi - this->particles.position(*b));
+    }
+
+    return sum;
+}
+
+template class BasicBoundaryParticles<float>;
+template class BasicBoundaryParticles<double>;
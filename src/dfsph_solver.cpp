@@ -0,0 +1,224 @@
+#include "../include/dfsph_solver.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+
+DfsphSolver::DfsphSolver(float smoothingRadius, float spacing)
+: Solver(smoothingRadius, spacing),
+  densityTolerance(DFSPH_DENSITY_TOLERANCE),
+  divergenceTolerance(DFSPH_DIVERGENCE_TOLERANCE),
+  maxIterations(DFSPH_MAX_ITERATIONS),
+  minNeighbours(DFSPH_MIN_NEIGHBOURS),
+  warmStartLimit(DFSPH_WARM_START_LIMIT),
+  densityIterations(0),
+  divergenceIterations(0),
+  densityError(0.0f),
+  divergenceError(0.0f) {}
+
+void DfsphSolver::resize(size_t n) {
+    for(AlignedVector<float> *column : { &this->alpha, &this->vx0, &this->vy0, &this->vz0, &this->gbx, &this->gby, &this->gbz }) {
+        column->resize(n);
+    }
+}
+
+template <typename Kernel>
+void DfsphSolver::computeFactors(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, const NeighbourList &neighbours,
+                                 size_t begin, size_t end) {
+    this->computeDensity(kernel, simd, particles, neighbours, begin, end);
+
+    for(size_t i = begin; i < end; i++) {
+        const uint32_t *nb = neighbours.begin(i);
+        uint32_t count = neighbours.count(i);
+
+        glm::vec3 sum(0.0f);
+        float sumDot = 0.0f;
+
+        for(uint32_t k = 0; k < count; k++) {
+            glm::vec3 gradient = this->neighbourMass(particles, nb[k]) * this->spikyGradient(kernel, particles, i, nb[k]);
+
+            sum += gradient;
+            sumDot += glm::dot(gradient, gradient);
+        }
+
+        // the boundary does not move, so it only adds to the sum of gradients
+        glm::vec3 boundary = this->boundaryGradient(particles, i);
+        sum += boundary;
+
+        this->gbx[i] = boundary.x;
+        this->gby[i] = boundary.y;
+        this->gbz[i] = boundary.z;
+
+        // lone particles get no correction instead of a huge one
+        float denominator = glm::dot(sum, sum) + sumDot;
+        this->alpha[i] = denominator > 1e-6f ? particles.density[i] / denominator : 0.0f;
+    }
+}
+
+template <typename Kernel>
+float DfsphSolver::densityChange(const Kernel &kernel, const ParticleSystem &particles, const NeighbourList &neighbours, size_t i) const {
+    const uint32_t *nb = neighbours.begin(i);
+    uint32_t count = neighbours.count(i);
+
+    glm::vec3 vi = particles.velocity(i);
+    float sum = 0.0f;
+
+    for(uint32_t k = 0; k < count; k++) {
+        uint32_t j = nb[k];
+        sum += particles.mass[j] * glm::dot(vi - particles.velocity(j), this->spikyGradient(kernel, particles, i, j));
+    }
+
+    return this->particleMass * sum + glm::dot(vi, glm::vec3(this->gbx[i], this->gby[i], this->gbz[i]));
+}
+
+template <typename Kernel>
+float DfsphSolver::source(const Kernel &kernel, const ParticleSystem &particles, const NeighbourList &neighbours, size_t i, float deltaTime,
+                          bool divergence) const {
+    // sparse particles (splashes, the free surface) are left to move freely,
+    // correcting them fully only throws them around
+    if(divergence && neighbours.count(i) < this->minNeighbours) return 0.0f;
+
+    float source = deltaTime * this->densityChange(kernel, particles, neighbours, i);
+    if(!divergence) source += particles.density[i] - this->restDensity;
+
+    return std::max(source, 0.0f);
+}
+
+// with p_i = kappa_i rho_i the symmetric pressure sum of the force kernel is
+// exactly sum_j (kappa_i / rho_i + kappa_j / rho_j) grad W_ij, the boundary
+// adds kappa_i / rho_i sum_b psi_b grad W_ib
+template <typename Kernel>
+void DfsphSolver::applyStiffness(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, const NeighbourList &neighbours,
+                                 ThreadPool &pool, float deltaTime) {
+    pool.parallelFor(0, particles.size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            float density2 = particles.density[i] * particles.density[i];
+
+            glm::vec3 correction = deltaTime * this->particleMass * simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i)).pressure
+                                 + deltaTime * particles.pressure[i] / density2 * glm::vec3(this->gbx[i], this->gby[i], this->gbz[i]);
+
+            particles.vx[i] -= correction.x;
+            particles.vy[i] -= correction.y;
+            particles.vz[i] -= correction.z;
+        }
+    });
+}
+
+template <typename Kernel>
+unsigned int DfsphSolver::solve(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, const NeighbourList &neighbours,
+                                ThreadPool &pool, float deltaTime, AlignedVector<float> &stored, bool divergence, float tolerance, unsigned int minIterations,
+                                float &error) {
+    const size_t n = particles.size();
+    const float inverseStep2 = 1.0f / (deltaTime * deltaTime);
+
+    // stored holds the accumulated density correction times alpha, which does
+    // not depend on the step size. half of it is applied up front, but only to
+    // particles that need a correction now and capped, a particle the last step
+    // pushed apart would otherwise be pushed again and gain energy every step
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            float limit = this->warmStartLimit * this->restDensity * this->alpha[i];
+
+            stored[i] = this->source(kernel, particles, neighbours, i, deltaTime, divergence) > 0.0f ? 0.5f * std::min(stored[i], limit) : 0.0f;
+            particles.pressure[i] = stored[i] * inverseStep2 * particles.density[i];
+        }
+    });
+
+    this->applyStiffness(kernel, simd, particles, neighbours, pool, deltaTime);
+
+    unsigned int iteration = 0;
+
+    while(true) {
+        float sum = pool.parallelReduce(0, n, 0.0f, [&](size_t begin, size_t end) {
+            float partial = 0.0f;
+
+            for(size_t i = begin; i < end; i++) {
+                float source = this->source(kernel, particles, neighbours, i, deltaTime, divergence);
+                particles.pressure[i] = source * this->alpha[i] * inverseStep2 * particles.density[i];
+
+                partial += source;
+            }
+
+            return partial;
+        }, [](float a, float b) { return a + b; });
+
+        error = n > 0 ? sum / (n * this->restDensity) : 0.0f;
+
+        if((error <= tolerance && iteration >= minIterations) || iteration >= this->maxIterations) break;
+
+        this->applyStiffness(kernel, simd, particles, neighbours, pool, deltaTime);
+
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) stored[i] += particles.pressure[i] / (inverseStep2 * particles.density[i]);
+        });
+
+        iteration++;
+    }
+
+    return iteration;
+}
+
+void DfsphSolver::step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) {
+    if(this->fixedKernel) this->step(DefaultSphKernel(), this->fixedSimd, particles, neighbours, pool, deltaTime);
+    else this->step(this->kernel, this->simd, particles, neighbours, pool, deltaTime);
+}
+
+template <typename Kernel>
+void DfsphSolver::step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+                       float deltaTime) {
+    const size_t n = particles.size();
+    this->resize(n);
+
+    if(deltaTime <= 0.0f) {
+        std::fill(particles.ax.begin(), particles.ax.end(), 0.0f);
+        std::fill(particles.ay.begin(), particles.ay.end(), 0.0f);
+        std::fill(particles.az.begin(), particles.az.end(), 0.0f);
+        return;
+    }
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) { this->computeFactors(kernel, simd, particles, neighbours, begin, end); });
+
+    // velocities left by the last integration, corrected in place
+    this->divergenceIterations = this->solve(kernel, simd, particles, neighbours, pool, deltaTime, particles.divergenceStiffness, true,
+                                             this->divergenceTolerance, 1, this->divergenceError);
+
+    // viscosity and gravity give the predicted velocities, the density solve corrects those
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        std::fill(particles.pressure.begin() + begin, particles.pressure.begin() + end, 0.0f);
+
+        for(size_t i = begin; i < end; i++) {
+            this->vx0[i] = particles.vx[i];
+            this->vy0[i] = particles.vy[i];
+            this->vz0[i] = particles.vz[i];
+        }
+    });
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ForceSums sums = simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i));
+            glm::vec3 acceleration = this->viscosity * this->particleMass / particles.density[i] * sums.viscosity;
+
+            particles.vx[i] += deltaTime * acceleration.x;
+            particles.vy[i] += deltaTime * (acceleration.y + particles.gravity);
+            particles.vz[i] += deltaTime * acceleration.z;
+        }
+    });
+
+    this->densityIterations = this->solve(kernel, simd, particles, neighbours, pool, deltaTime, particles.stiffness, false,
+                                          this->densityTolerance, 2, this->densityError);
+
+    // hand the change back to the integrator as an acceleration so it stays the
+    // only place that moves particles and handles the walls
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            particles.ax[i] = (particles.vx[i] - this->vx0[i]) / deltaTime;
+            particles.ay[i] = (particles.vy[i] - this->vy0[i]) / deltaTime - particles.gravity;
+            particles.az[i] = (particles.vz[i] - this->vz0[i]) / deltaTime;
+
+            particles.vx[i] = this->vx0[i];
+            particles.vy[i] = this->vy0[i];
+            particles.vz[i] = this->vz0[i];
+        }
+    });
+
+    this->countIterations(this->divergenceIterations + this->densityIterations);
+}
@@ -0,0 +1,196 @@
+#include "../include/iisph_solver.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+IisphSolver::IisphSolver(float smoothingRadius, float spacing)
+: Solver(smoothingRadius, spacing),
+  omega(IISPH_OMEGA),
+  tolerance(IISPH_TOLERANCE),
+  minIterations(IISPH_MIN_ITERATIONS),
+  maxIterations(IISPH_MAX_ITERATIONS),
+  densityError(0.0f) {}
+
+void IisphSolver::resize(size_t n) {
+    for(AlignedVector<float> *column : { &this->anx, &this->any, &this->anz, &this->diix, &this->diiy, &this->diiz,
+                                         &this->sumx, &this->sumy, &this->sumz, &this->gbx, &this->gby, &this->gbz, &this->aii, &this->advectedDensity, &this->nextPressure }) {
+        column->resize(n);
+    }
+}
+
+void IisphSolver::step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) {
+    if(this->fixedKernel) this->step(DefaultSphKernel(), this->fixedSimd, particles, neighbours, pool, deltaTime);
+    else this->step(this->kernel, this->simd, particles, neighbours, pool, deltaTime);
+}
+
+template <typename Kernel>
+void IisphSolver::step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+                       float deltaTime) {
+    const size_t n = particles.size();
+    const float mass = this->particleMass;
+    const float dt2 = deltaTime * deltaTime;
+
+    this->resize(n);
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) { this->computeDensity(kernel, simd, particles, neighbours, begin, end); });
+
+    // non-pressure accelerations and d_ii
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            const uint32_t *nb = neighbours.begin(i);
+            uint32_t count = neighbours.count(i);
+
+            ForceSums sums = simd.forceSums(kernel, particles, i, nb, count);
+            glm::vec3 acceleration = this->viscosity * mass / particles.density[i] * sums.viscosity;
+
+            this->anx[i] = acceleration.x;
+            this->any[i] = acceleration.y;
+            this->anz[i] = acceleration.z;
+
+            glm::vec3 gradientSum(0.0f);
+
+            for(uint32_t k = 0; k < count; k++) gradientSum += particles.mass[nb[k]] * this->spikyGradient(kernel, particles, i, nb[k]);
+
+            glm::vec3 boundary = this->boundaryGradient(particles, i);
+
+            this->gbx[i] = boundary.x;
+            this->gby[i] = boundary.y;
+            this->gbz[i] = boundary.z;
+
+            glm::vec3 dii = -dt2 / (particles.density[i] * particles.density[i]) * (mass * gradientSum + boundary);
+
+            this->diix[i] = dii.x;
+            this->diiy[i] = dii.y;
+            this->diiz[i] = dii.z;
+        }
+    });
+
+    // density after advection, the diagonal a_ii and the warm start
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            const uint32_t *nb = neighbours.begin(i);
+            uint32_t count = neighbours.count(i);
+
+            glm::vec3 vi = particles.velocity(i) + deltaTime * glm::vec3(this->anx[i], this->any[i], this->anz[i]);
+            glm::vec3 dii(this->diix[i], this->diiy[i], this->diiz[i]);
+            float densityI2 = particles.density[i] * particles.density[i];
+            float massI = this->neighbourMass(particles, i);
+
+            float change = 0.0f;
+            float diagonal = 0.0f;
+
+            for(uint32_t k = 0; k < count; k++) {
+                uint32_t j = nb[k];
+
+                glm::vec3 gradient = this->spikyGradient(kernel, particles, i, j);
+                glm::vec3 vj = particles.velocity(j) + deltaTime * glm::vec3(this->anx[j], this->any[j], this->anz[j]);
+
+                // d_ji, the push particle i's pressure gives j
+                glm::vec3 dji = dt2 * massI / densityI2 * gradient;
+
+                change += particles.mass[j] * glm::dot(vi - vj, gradient);
+                diagonal += particles.mass[j] * glm::dot(dii - dji, gradient);
+            }
+
+            // the boundary is at rest and only sees particle i's own pressure
+            glm::vec3 boundary(this->gbx[i], this->gby[i], this->gbz[i]);
+
+            this->advectedDensity[i] = particles.density[i] + deltaTime * (mass * change + glm::dot(vi, boundary));
+            this->aii[i] = mass * diagonal + glm::dot(dii, boundary);
+
+            particles.pressure[i] *= 0.5f;
+        }
+    });
+
+    unsigned int iteration = 0;
+
+    while(true) {
+        // sum_j d_ij p_j with the current iterate
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                const uint32_t *nb = neighbours.begin(i);
+                uint32_t count = neighbours.count(i);
+
+                glm::vec3 sum(0.0f);
+
+                for(uint32_t k = 0; k < count; k++) {
+                    uint32_t j = nb[k];
+                    sum += particles.mass[j] * particles.pressure[j] / (particles.density[j] * particles.density[j]) * this->spikyGradient(kernel, particles, i, j);
+                }
+
+                sum *= -dt2 * mass;
+
+                this->sumx[i] = sum.x;
+                this->sumy[i] = sum.y;
+                this->sumz[i] = sum.z;
+            }
+        });
+
+        // relaxed Jacobi update, summing the remaining compression on the way
+        float compression = pool.parallelReduce(0, n, 0.0f, [&](size_t begin, size_t end) {
+            float partial = 0.0f;
+
+            for(size_t i = begin; i < end; i++) {
+                const uint32_t *nb = neighbours.begin(i);
+                uint32_t count = neighbours.count(i);
+
+                glm::vec3 sumI(this->sumx[i], this->sumy[i], this->sumz[i]);
+                float pressureI = particles.pressure[i];
+                float densityI2 = particles.density[i] * particles.density[i];
+                float massI = this->neighbourMass(particles, i);
+
+                float offDiagonal = 0.0f;
+
+                for(uint32_t k = 0; k < count; k++) {
+                    uint32_t j = nb[k];
+
+                    glm::vec3 gradient = this->spikyGradient(kernel, particles, i, j);
+                    glm::vec3 djj(this->diix[j], this->diiy[j], this->diiz[j]);
+                    glm::vec3 sumJ(this->sumx[j], this->sumy[j], this->sumz[j]);
+                    glm::vec3 dji = dt2 * massI / densityI2 * gradient;
+
+                    offDiagonal += particles.mass[j] * glm::dot(sumI - djj * particles.pressure[j] - (sumJ - dji * pressureI), gradient);
+                }
+
+                offDiagonal = mass * offDiagonal + glm::dot(sumI, glm::vec3(this->gbx[i], this->gby[i], this->gbz[i]));
+
+                float source = this->restDensity - this->advectedDensity[i];
+                float next = 0.0f;
+
+                if(std::abs(this->aii[i]) > 1e-9f) {
+                    next = std::max(0.0f, (1.0f - this->omega) * pressureI + this->omega / this->aii[i] * (source - offDiagonal));
+                }
+
+                this->nextPressure[i] = next;
+
+                // predicted density minus rest density with the current iterate
+                partial += std::max(0.0f, this->aii[i] * pressureI + offDiagonal - source);
+            }
+
+            return partial;
+        }, [](float a, float b) { return a + b; });
+
+        particles.pressure.swap(this->nextPressure);
+        iteration++;
+
+        this->densityError = n > 0 ? compression / (n * this->restDensity) : 0.0f;
+
+        if((this->densityError <= this->tolerance && iteration >= this->minIterations) || iteration >= this->maxIterations) break;
+    }
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            float density2 = particles.density[i] * particles.density[i];
+
+            glm::vec3 acceleration = -mass * simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i)).pressure
+                                   - particles.pressure[i] / density2 * glm::vec3(this->gbx[i], this->gby[i], this->gbz[i]);
+
+            particles.ax[i] = this->anx[i] + acceleration.x;
+            particles.ay[i] = this->any[i] + acceleration.y;
+            particles.az[i] = this->anz[i] + acceleration.z;
+        }
+    });
+
+    this->countIterations(iteration);
+}
@@ -1,5 +1,6 @@
 #include "../include/mesh.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <string>
 
@@ -61,13 +62,13 @@ void Mesh::draw(Shader &shader) const {
     glActiveTexture(GL_TEXTURE0);
 }
 
-void Mesh::drawInstanced(Shader &shader, const std::vector<glm::mat4> &modelMatrices) {
+// the matrix of an instance goes to attributes 3 to 6, one column each
+void Mesh::reserveInstances(size_t count) {
     glBindVertexArray(this->VAO);
 
-    if (this->instanceVBO == 0) {
+    if(this->instanceVBO == 0) {
         glGenBuffers(1, &this->instanceVBO);
         glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER, modelMatrices.size() * sizeof(glm::mat4), &modelMatrices[0], GL_DYNAMIC_DRAW);
 
         for(unsigned int j = 0; j < 4; j++) {
             glEnableVertexAttribArray(3 + j);
@@ -76,9 +77,25 @@ void Mesh::drawInstanced(Shader &shader, const std::vector<glm::mat4> &modelMatr
         }
     } else {
         glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, modelMatrices.size() * sizeof(glm::mat4), &modelMatrices[0]);
     }
 
+    if(count > this->instanceCapacity) {
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+        this->instanceCapacity = count;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void Mesh::drawInstanced(Shader &shader, const std::vector<glm::mat4> &modelMatrices) {
+    // only grows when nothing reserved the buffer for the largest count
+    if(modelMatrices.size() > this->instanceCapacity || this->instanceVBO == 0) this->reserveInstances(modelMatrices.size());
+
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, modelMatrices.size() * sizeof(glm::mat4), &modelMatrices[0]);
+
     if(textures.size() > 0) {
         unsigned int diffuseNr = 1;
         unsigned int specularNr = 1;
@@ -21,6 +21,20 @@ void Model::drawInstanced(Shader &shader, const std::vector<glm::mat4> &modelMat
     for(unsigned int i = 0; i < this->meshes.size(); i++) meshes[i].drawInstanced(shader, modelMatrices);
 }
 
+void Model::reserveInstances(size_t count) {
+    for(unsigned int i = 0; i < this->meshes.size(); i++) meshes[i].reserveInstances(count);
+}
+
+std::vector<glm::vec3> Model::triangles(const glm::mat4 &transform) const {
+    std::vector<glm::vec3> corners;
+
+    for(const Mesh &mesh : this->meshes) {
+        for(unsigned int index : mesh.indices) corners.push_back(glm::vec3(transform * glm::vec4(mesh.vertices[index].position, 1.0f)));
+    }
+
+    return corners;
+}
+
 void Model::loadModel(std::string path) {
     Assimp::Importer importer;
 
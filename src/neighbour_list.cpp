@@ -0,0 +1,140 @@
+#include "../include/neighbour_list.hpp"
+
+#include <algorithm>
+
+NeighbourList::NeighbourList(float radius, size_t particleCount, float skin, size_t expectedNeighbours)
+: radius(radius), skin(skin), expectedNeighbours(expectedNeighbours), updates(0), rebuilds(0) {
+    this->reserve(particleCount);
+}
+
+void NeighbourList::reserve(size_t capacity) {
+    if(this->offsets.size() < capacity + 1) this->offsets.resize(capacity + 1);
+    if(this->indices.size() < capacity * this->expectedNeighbours) this->indices.resize(capacity * this->expectedNeighbours);
+
+    this->refX.reserve(capacity);
+    this->refY.reserve(capacity);
+    this->refZ.reserve(capacity);
+}
+
+template <typename Real>
+bool NeighbourList::needsRebuild(const BasicParticleSystem<Real> &particles, ThreadPool &pool) const {
+    if(this->refX.size() != particles.size()) return true;
+
+    const Real *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+    const float limit2 = 0.25f * this->skin * this->skin;
+
+    float max2 = pool.parallelReduce(0, particles.size(), 0.0f, [&](size_t begin, size_t end) {
+        float partial = 0.0f;
+
+        for(size_t i = begin; i < end; i++) {
+            float dx = px[i] - this->refX[i];
+            float dy = py[i] - this->refY[i];
+            float dz = pz[i] - this->refZ[i];
+
+            partial = std::max(partial, dx * dx + dy * dy + dz * dz);
+        }
+
+        return partial;
+    }, [](float a, float b) { return std::max(a, b); });
+
+    return max2 > limit2;
+}
+
+// rebuilds grid and lists only when the skin no longer covers the motion since the
+// last build, returns true if it did
+template <typename Real>
+bool NeighbourList::update(BasicParticleSystem<Real> &particles, UniformGrid &grid, ThreadPool &pool, bool allowReorder) {
+    this->updates++;
+
+    if(!this->needsRebuild(particles, pool)) return false;
+
+    grid.build(particles, pool, allowReorder);
+    this->build(particles, grid, pool);
+
+    this->refX.assign(particles.px.begin(), particles.px.end());
+    this->refY.assign(particles.py.begin(), particles.py.end());
+    this->refZ.assign(particles.pz.begin(), particles.pz.end());
+
+    this->rebuilds++;
+
+    return true;
+}
+
+// walks every source particle of the 27 cells around particle i and calls f(j) for the ones within radius
+template <typename Real, typename F>
+void NeighbourList::forEachNeighbour(const BasicParticleSystem<Real> &particles, const BasicParticleSystem<Real> &sources, const UniformGrid &grid, size_t i, F f) const {
+    const Real *px = sources.px.data(), *py = sources.py.data(), *pz = sources.pz.data();
+    const Real x = particles.px[i], y = particles.py[i], z = particles.pz[i];
+    const Real cutoff = this->radius + this->skin;
+    const Real radius2 = cutoff * cutoff;
+
+    glm::ivec3 cell = grid.cellCoord(particles.position(i));
+
+    for(int dx = -1; dx <= 1; dx++) {
+        for(int dy = -1; dy <= 1; dy++) {
+            for(int dz = -1; dz <= 1; dz++) {
+                uint32_t c = grid.cellIndex(cell + glm::ivec3(dx, dy, dz));
+                if(c == UniformGrid::EMPTY) continue;
+
+                for(uint32_t k = grid.cellStart[c]; k < grid.cellEnd[c]; k++) {
+                    uint32_t j = grid.particleIndex[k];
+
+                    Real rx = x - px[j];
+                    Real ry = y - py[j];
+                    Real rz = z - pz[j];
+
+                    if(rx * rx + ry * ry + rz * rz <= radius2) f(j);
+                }
+            }
+        }
+    }
+}
+
+template <typename Real>
+void NeighbourList::build(const BasicParticleSystem<Real> &particles, const UniformGrid &grid, ThreadPool &pool) {
+    this->build(particles, particles, grid, pool);
+}
+
+template <typename Real>
+void NeighbourList::build(const BasicParticleSystem<Real> &particles, const BasicParticleSystem<Real> &sources, const UniformGrid &grid, ThreadPool &pool) {
+    const size_t n = particles.size();
+
+    if(this->offsets.size() < n + 1) this->offsets.resize(n + 1);
+
+    // count pass, then an exclusive prefix sum gives every particle its slice
+    uint32_t *offsets = this->offsets.data();
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            uint32_t count = 0;
+            this->forEachNeighbour(particles, sources, grid, i, [&count](uint32_t) { count++; });
+
+            offsets[i] = count;
+        }
+    });
+
+    uint32_t total = 0;
+    for(size_t i = 0; i < n; i++) {
+        uint32_t count = offsets[i];
+        offsets[i] = total;
+        total += count;
+    }
+    offsets[n] = total;
+
+    // only grows, reserve() covers the usual densities up front
+    if(this->indices.size() < total) this->indices.resize(total + total / 4);
+
+    uint32_t *indices = this->indices.data();
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            uint32_t cursor = offsets[i];
+            this->forEachNeighbour(particles, sources, grid, i, [indices, &cursor](uint32_t j) { indices[cursor++] = j; });
+        }
+    });
+}
+
+template bool NeighbourList::update(ParticleSystem&, UniformGrid&, ThreadPool&, bool);
+template bool NeighbourList::update(BasicParticleSystem<double>&, UniformGrid&, ThreadPool&, bool);
+template void NeighbourList::build(const ParticleSystem&, const UniformGrid&, ThreadPool&);
+template void NeighbourList::build(const BasicParticleSystem<double>&, const UniformGrid&, ThreadPool&);
+template void NeighbourList::build(const ParticleSystem&, const ParticleSystem&, const UniformGrid&, ThreadPool&);
+template void NeighbourList::build(const BasicParticleSystem<double>&, const BasicParticleSystem<double>&, const UniformGrid&, ThreadPool&);
@@ -2,99 +2,53 @@
 #include "../include/constants.hpp"
 
 #include "../include/glm/glm.hpp"
-#include "../include/glm/gtc/matrix_transform.hpp"
 
-#include <algorithm>
 #include <cstdlib>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
 
-Particle::Particle(glm::vec3 position, glm::mat4 model) : position(position), model(model) {
-    this->velocity = glm::vec3(0.0f, 0.0f, 0.0f);
-    this->acceleration = glm::vec3(0.0f, GRAVITY, 0.0f);
-    this->force = glm::vec3(0.0f);
+Particle::Particle(ParticleSystem &system, uint32_t index) : index(index), system(&system) {}
 
-    this->calcCell();
-    this->calcHash();
-
-    this->density = 0.0f;
-    this->pressure = 0.0f;
+glm::vec3 Particle::position() const {
+    return this->system->position(this->index);
 }
 
-void Particle::calcCell() {
-    
-    this->cell = this->position / TRANSLATE;
+glm::vec3 Particle::velocity() const {
+    return this->system->velocity(this->index);
 }
 
-void Particle::calcHash() {
-    this->hash = this->cellHash(this->cell);
+glm::mat4 Particle::model() const {
+    return this->system->model(this->index);
 }
 
-uint Particle::cellHash(const glm::ivec3 &cell) {
-    return ((uint)(cell.x * 73856093) ^
-            (uint)(cell.y * 19349663) ^
-            (uint)(cell.z * 83492791) % PARTICLE_COUNT);
+uint Particle::hash() const {
+    return this->system->hash[this->index];
 }
 
-glm::mat4 Particle::updatePhysics(float deltaTime) {
-
-    this->velocity += this->acceleration * deltaTime;
-    this->position += this->velocity * deltaTime;
-    
-    if(this->position.y <= 0.0f) {
-        this->position.y = 0.0f;
-        this->velocity.y *= -0.9f;
-
-        if(glm::abs(this->velocity.y) < 0.1f) this->velocity.y = 0.0f;
-    }
-
-    if (std::abs(this->position.x) >= BOX_SIZE) {
-        this->position.x = (this->position.x > 0.0f) ? BOX_SIZE : -BOX_SIZE;
-        this->velocity.x *= -0.9f;
-    }
-
-    if (std::abs(this->position.z) >= BOX_SIZE) {
-        this->position.z = (this->position.z > 0.0f) ? BOX_SIZE : -BOX_SIZE;
-        this->velocity.z *= -0.9f;
-    }
-
-    this->model = glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(SCALE)), this->position);
-    this->calcCell();
-    this->calcHash();
-
-    return this->model;
+float Particle::density() const {
+    return this->system->density[this->index];
 }
 
-void Particle::sortParticles(std::vector<Particle*> particles) {
-    std::sort(particles.begin(), particles.end(), [](const Particle* i, const Particle* j) { return i->hash < j->hash; });
+float Particle::pressure() const {
+    return this->system->pressure[this->index];
 }
 
-std::unordered_map<uint32_t, uint32_t> Particle::neighbourTable(std::vector<Particle*> sortedParticles) {
-    std::unordered_map<uint32_t, uint32_t> neighbourTable;
+void Particle::remap() {
+    this->index = this->system->remapped(this->index);
+}
 
-    for (size_t i = 0; i < PARTICLE_COUNT; i++) {
-        neighbourTable[sortedParticles[i]->hash] = i;
-    }
+glm::mat4 Particle::updatePhysics(float deltaTime) {
+    this->system->integrate(this->index, this->index + 1, deltaTime);
 
-    return neighbourTable;
+    return this->model();
 }
 
-void Particle::getNeighbours(std::vector<Particle*> sortedParticles, std::unordered_map<uint32_t, uint32_t> &neighbourTable) {
-    std::unordered_set<Particle*> neighbours;
+std::vector<Particle> Particle::getNeighbours(const NeighbourList &neighbours) const {
+    std::vector<Particle> result;
+    result.reserve(neighbours.count(this->index));
 
-    for(int dx = -1; dx <= 1; dx++) {
-        for(int dy = -1; dy <= 1; dy++) {
-            for(int dz = -1; dz <= 1; dz++) {
-                glm::ivec3 neighbourCell = this->cell + glm::ivec3(dx, dy, dz);
-                uint32_t neighbourHash = this->cellHash(neighbourCell);
-                if(neighbourTable.find(neighbourHash) != neighbourTable.end()) {
-                    Particle* neighbourParticle = sortedParticles[neighbourTable[neighbourHash]];
-                    neighbours.insert(neighbourParticle);
-                }
-            }
-        }
+    for(const uint32_t *j = neighbours.begin(this->index); j != neighbours.end(this->index); j++) {
+        result.push_back(Particle(*this->system, *j));
     }
 
-    this->neighbours = std::vector<Particle*>(neighbours.begin(), neighbours.end());
-}
\ No newline at end of file
+    return result;
+}
@@ -0,0 +1,248 @@
+#include "../include/particle_system.hpp"
+#include "../include/constants.hpp"
+#include "../include/integrators.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+template <typename Real>
+BasicParticleSystem<Real>::BasicParticleSystem() : gravity(GRAVITY), boxSize(BOX_SIZE) {}
+
+template <typename Real>
+void BasicParticleSystem<Real>::reserve(size_t count) {
+    this->px.reserve(count);
+    this->py.reserve(count);
+    this->pz.reserve(count);
+    this->vx.reserve(count);
+    this->vy.reserve(count);
+    this->vz.reserve(count);
+    this->ax.reserve(count);
+    this->ay.reserve(count);
+    this->az.reserve(count);
+    this->prevX.reserve(count);
+    this->prevY.reserve(count);
+    this->prevZ.reserve(count);
+    this->prevAx.reserve(count);
+    this->prevAy.reserve(count);
+    this->prevAz.reserve(count);
+    this->density.reserve(count);
+    this->pressure.reserve(count);
+    this->stiffness.reserve(count);
+    this->divergenceStiffness.reserve(count);
+    this->mass.reserve(count);
+    this->smoothing.reserve(count);
+    this->hash.reserve(count);
+
+    // permute() swaps the scratch columns with the store's, they have to hold as much
+    this->scratch.reserve(count);
+    this->scratchIndex.reserve(count);
+    this->newIndex.reserve(count);
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::clear() {
+    this->px.clear();
+    this->py.clear();
+    this->pz.clear();
+    this->vx.clear();
+    this->vy.clear();
+    this->vz.clear();
+    this->ax.clear();
+    this->ay.clear();
+    this->az.clear();
+    this->prevX.clear();
+    this->prevY.clear();
+    this->prevZ.clear();
+    this->prevAx.clear();
+    this->prevAy.clear();
+    this->prevAz.clear();
+    this->density.clear();
+    this->pressure.clear();
+    this->stiffness.clear();
+    this->divergenceStiffness.clear();
+    this->mass.clear();
+    this->smoothing.clear();
+    this->hash.clear();
+}
+
+template <typename Real>
+size_t BasicParticleSystem<Real>::add(Vec3 position, Vec3 velocity, Real mass) {
+    size_t index = this->size();
+
+    this->px.push_back(position.x);
+    this->py.push_back(position.y);
+    this->pz.push_back(position.z);
+    this->vx.push_back(velocity.x);
+    this->vy.push_back(velocity.y);
+    this->vz.push_back(velocity.z);
+    this->ax.push_back(0);
+    this->ay.push_back(0);
+    this->az.push_back(0);
+    this->prevX.push_back(position.x);
+    this->prevY.push_back(position.y);
+    this->prevZ.push_back(position.z);
+    this->prevAx.push_back(0);
+    this->prevAy.push_back(0);
+    this->prevAz.push_back(0);
+    this->density.push_back(0);
+    this->pressure.push_back(0);
+    this->stiffness.push_back(0);
+    this->divergenceStiffness.push_back(0);
+    this->mass.push_back(mass);
+    this->smoothing.push_back(std::cbrt(mass));
+    this->hash.push_back(0);
+
+    return index;
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::setPosition(size_t i, Vec3 position) {
+    this->px[i] = position.x;
+    this->py[i] = position.y;
+    this->pz[i] = position.z;
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::setVelocity(size_t i, Vec3 velocity) {
+    this->vx[i] = velocity.x;
+    this->vy[i] = velocity.y;
+    this->vz[i] = velocity.z;
+}
+
+template <typename Real>
+template <typename T>
+void BasicParticleSystem<Real>::gather(AlignedVector<T> &column, AlignedVector<T> &scratch, const std::vector<uint32_t> &order) {
+    scratch.resize(order.size());
+
+    for(size_t i = 0; i < order.size(); i++) scratch[i] = column[order[i]];
+
+    column.swap(scratch);
+}
+
+// reorders every column so that new index i holds the particle previously at order[i].
+// the scratch columns are swapped in and out, after reserve() every buffer taking
+// part has the same capacity and a store within it never allocates here
+template <typename Real>
+void BasicParticleSystem<Real>::permute(const std::vector<uint32_t> &order) {
+    this->gather(this->px, this->scratch, order);
+    this->gather(this->py, this->scratch, order);
+    this->gather(this->pz, this->scratch, order);
+    this->gather(this->vx, this->scratch, order);
+    this->gather(this->vy, this->scratch, order);
+    this->gather(this->vz, this->scratch, order);
+    this->gather(this->ax, this->scratch, order);
+    this->gather(this->ay, this->scratch, order);
+    this->gather(this->az, this->scratch, order);
+    this->gather(this->prevX, this->scratch, order);
+    this->gather(this->prevY, this->scratch, order);
+    this->gather(this->prevZ, this->scratch, order);
+    this->gather(this->prevAx, this->scratch, order);
+    this->gather(this->prevAy, this->scratch, order);
+    this->gather(this->prevAz, this->scratch, order);
+    this->gather(this->density, this->scratch, order);
+    this->gather(this->pressure, this->scratch, order);
+    this->gather(this->stiffness, this->scratch, order);
+    this->gather(this->divergenceStiffness, this->scratch, order);
+    this->gather(this->mass, this->scratch, order);
+    this->gather(this->smoothing, this->scratch, order);
+
+    size_t previousSize = this->hash.size();
+    this->gather(this->hash, this->scratchIndex, order);
+
+    this->newIndex.assign(previousSize, 0xffffffffu);
+    for(size_t i = 0; i < order.size(); i++) this->newIndex[order[i]] = i;
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::integrate(Real deltaTime, ThreadPool &pool) {
+    pool.parallelFor(0, this->size(), [&](size_t begin, size_t end) { this->integrate(begin, end, deltaTime); });
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::integrate(size_t begin, size_t end, Real deltaTime) {
+    this->template integrate<SemiImplicitEuler>(begin, end, deltaTime, deltaTime);
+}
+
+template <typename Real>
+template <typename Integrator>
+void BasicParticleSystem<Real>::integrate(size_t begin, size_t end, Real deltaTime, Real previousDeltaTime) {
+    const Real gravity = this->gravity, box = this->boxSize;
+    const Real restitution = -0.9, rest = 0.1;
+
+    Real *px = this->px.data(), *py = this->py.data(), *pz = this->pz.data();
+    Real *vx = this->vx.data(), *vy = this->vy.data(), *vz = this->vz.data();
+    const Real *ax = this->ax.data(), *ay = this->ay.data(), *az = this->az.data();
+    Real *prevAx = this->prevAx.data(), *prevAy = this->prevAy.data(), *prevAz = this->prevAz.data();
+
+    for(size_t i = begin; i < end; i++) {
+        Integrator::step(px[i], vx[i], prevAx[i], ax[i], deltaTime, previousDeltaTime);
+        Integrator::step(py[i], vy[i], prevAy[i], ay[i] + gravity, deltaTime, previousDeltaTime);
+        Integrator::step(pz[i], vz[i], prevAz[i], az[i], deltaTime, previousDeltaTime);
+
+        if(py[i] <= 0) {
+            py[i] = 0;
+            vy[i] *= restitution;
+
+            if(std::abs(vy[i]) < rest) vy[i] = 0;
+        }
+
+        if(std::abs(px[i]) >= box) {
+            px[i] = (px[i] > 0) ? box : -box;
+            vx[i] *= restitution;
+        }
+
+        if(std::abs(pz[i]) >= box) {
+            pz[i] = (pz[i] > 0) ? box : -box;
+            vz[i] *= restitution;
+        }
+    }
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::savePositions(ThreadPool &pool) {
+    pool.parallelFor(0, this->size(), [&](size_t begin, size_t end) {
+        std::copy(this->px.begin() + begin, this->px.begin() + end, this->prevX.begin() + begin);
+        std::copy(this->py.begin() + begin, this->py.begin() + end, this->prevY.begin() + begin);
+        std::copy(this->pz.begin() + begin, this->pz.begin() + end, this->prevZ.begin() + begin);
+    });
+}
+
+// equivalent to glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(SCALE)), position)
+// without the two full matrix products per particle, the sphere is drawn at
+// the particle's own size
+template <typename Real>
+glm::mat4 BasicParticleSystem<Real>::model(size_t i) const {
+    glm::mat4 model(SCALE * (float)this->smoothing[i]);
+    model[3] = glm::vec4(glm::vec3(this->position(i)) * SCALE, 1.0f);
+
+    return model;
+}
+
+template <typename Real>
+glm::mat4 BasicParticleSystem<Real>::model(size_t i, float alpha) const {
+    glm::vec3 previous(this->prevX[i], this->prevY[i], this->prevZ[i]);
+
+    glm::mat4 model(SCALE * (float)this->smoothing[i]);
+    model[3] = glm::vec4(glm::mix(previous, glm::vec3(this->position(i)), alpha) * SCALE, 1.0f);
+
+    return model;
+}
+
+template <typename Real>
+void BasicParticleSystem<Real>::fillModelMatrices(std::vector<glm::mat4> &modelMatrices, ThreadPool &pool, float alpha) const {
+    modelMatrices.resize(this->size());
+
+    pool.parallelFor(0, this->size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) modelMatrices[i] = this->model(i, alpha);
+    });
+}
+
+template class BasicParticleSystem<float>;
+template class BasicParticleSystem<double>;
+
+template void BasicParticleSystem<float>::integrate<SemiImplicitEuler>(size_t, size_t, float, float);
+template void BasicParticleSystem<float>::integrate<Leapfrog>(size_t, size_t, float, float);
+template void BasicParticleSystem<float>::integrate<VelocityVerlet>(size_t, size_t, float, float);
+template void BasicParticleSystem<double>::integrate<SemiImplicitEuler>(size_t, size_t, double, double);
+template void BasicParticleSystem<double>::integrate<Leapfrog>(size_t, size_t, double, double);
+template void BasicParticleSystem<double>::integrate<VelocityVerlet>(size_t, size_t, double, double);
@@ -0,0 +1,195 @@
+#include "../include/pbf_solver.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PbfSolver::PbfSolver(float smoothingRadius, float spacing)
+: Solver(smoothingRadius, spacing),
+  constraintIterations(PBF_ITERATIONS),
+  relaxation(PBF_RELAXATION),
+  correctionK(PBF_CORRECTION_K),
+  correctionN(PBF_CORRECTION_N),
+  correctionDq(PBF_CORRECTION_DQ * smoothingRadius),
+  densityError(0.0f) {
+    int reach = (int)std::ceil(this->kernel.h / spacing);
+    float scale = this->particleMass / this->restDensity;
+
+    glm::vec3 sum(0.0f);
+    float sumDot = 0.0f;
+
+    for(int x = -reach; x <= reach; x++) {
+        for(int y = -reach; y <= reach; y++) {
+            for(int z = -reach; z <= reach; z++) {
+                glm::vec3 gradient = scale * this->kernel.spikyGradient(spacing * glm::vec3(x, y, z));
+
+                sum += gradient;
+                sumDot += glm::dot(gradient, gradient);
+            }
+        }
+    }
+
+    this->gradientTerm = glm::dot(sum, sum) + sumDot;
+}
+
+void PbfSolver::resize(size_t n) {
+    for(AlignedVector<float> *column : { &this->x0, &this->y0, &this->z0, &this->lambda, &this->dx, &this->dy, &this->dz, &this->gbx, &this->gby, &this->gbz }) {
+        column->resize(n);
+    }
+}
+
+void PbfSolver::step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) {
+    if(this->fixedKernel) this->step(DefaultSphKernel(), this->fixedSimd, particles, neighbours, pool, deltaTime);
+    else this->step(this->kernel, this->simd, particles, neighbours, pool, deltaTime);
+}
+
+template <typename Kernel>
+void PbfSolver::step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+                     float deltaTime) {
+    const size_t n = particles.size();
+    const float scale = this->particleMass / this->restDensity;
+    const float epsilon = this->relaxation * this->gradientTerm;
+    const float correctionW = kernel.poly6(this->correctionDq * this->correctionDq);
+
+    this->resize(n);
+
+    if(deltaTime <= 0.0f) {
+        std::fill(particles.ax.begin(), particles.ax.end(), 0.0f);
+        std::fill(particles.ay.begin(), particles.ay.end(), 0.0f);
+        std::fill(particles.az.begin(), particles.az.end(), 0.0f);
+        return;
+    }
+
+    // viscosity needs the densities at the current positions
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        this->computeDensity(kernel, simd, particles, neighbours, begin, end);
+        std::fill(particles.pressure.begin() + begin, particles.pressure.begin() + end, 0.0f);
+    });
+
+    // predicted velocities go into ax/ay/az for now, the positions are predicted
+    // once every particle has its velocity since viscosity reads the neighbours
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ForceSums sums = simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i));
+            glm::vec3 velocity = particles.velocity(i) + deltaTime * (this->viscosity * this->particleMass / particles.density[i] * sums.viscosity);
+            velocity.y += deltaTime * particles.gravity;
+
+            particles.ax[i] = velocity.x;
+            particles.ay[i] = velocity.y;
+            particles.az[i] = velocity.z;
+        }
+    });
+
+    this->x0.assign(particles.px.begin(), particles.px.end());
+    this->y0.assign(particles.py.begin(), particles.py.end());
+    this->z0.assign(particles.pz.begin(), particles.pz.end());
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            particles.px[i] = std::clamp(particles.px[i] + deltaTime * particles.ax[i], -particles.boxSize, particles.boxSize);
+            particles.py[i] = std::max(particles.py[i] + deltaTime * particles.ay[i], 0.0f);
+            particles.pz[i] = std::clamp(particles.pz[i] + deltaTime * particles.az[i], -particles.boxSize, particles.boxSize);
+        }
+    });
+
+    for(unsigned int iteration = 0; iteration < this->constraintIterations; iteration++) {
+        // the lists were built around the start of step positions
+        this->followPrediction(particles, neighbours, pool);
+
+        // lambda_i = -C_i / (sum_k |grad_k C_i|^2 + epsilon)
+        float compression = pool.parallelReduce(0, n, 0.0f, [&](size_t begin, size_t end) {
+            float partial = 0.0f;
+
+            for(size_t i = begin; i < end; i++) {
+                const uint32_t *nb = neighbours.begin(i);
+                uint32_t count = neighbours.count(i);
+
+                float density = this->particleMass * simd.densitySum(kernel, particles, i, nb, count)
+                              + this->boundaryDensity(particles, i);
+                float constraint = density / this->restDensity - 1.0f;
+
+                glm::vec3 sum(0.0f);
+                float sumDot = 0.0f;
+
+                for(uint32_t k = 0; k < count; k++) {
+                    glm::vec3 gradient = scale * particles.mass[nb[k]] * this->spikyGradient(kernel, particles, i, nb[k]);
+
+                    sum += gradient;
+                    sumDot += glm::dot(gradient, gradient);
+                }
+
+                // boundary particles are static, they add to the gradient with respect to x_i only
+                glm::vec3 boundary = this->boundaryGradient(particles, i) / this->restDensity;
+                sum += boundary;
+
+                this->gbx[i] = boundary.x;
+                this->gby[i] = boundary.y;
+                this->gbz[i] = boundary.z;
+
+                // only compression is corrected, a free surface would otherwise be pulled together
+                this->lambda[i] = -std::max(constraint, 0.0f) / (glm::dot(sum, sum) + sumDot + epsilon);
+                particles.density[i] = density;
+
+                partial += std::max(constraint, 0.0f);
+            }
+
+            return partial;
+        }, [](float a, float b) { return a + b; });
+
+        this->densityError = n > 0 ? compression / n : 0.0f;
+
+        // delta p_i = 1 / rho_0 sum_j m_j (lambda_i + lambda_j + s_corr) grad W_ij
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                const uint32_t *nb = neighbours.begin(i);
+                uint32_t count = neighbours.count(i);
+
+                glm::vec3 xi = particles.position(i);
+                glm::vec3 delta(0.0f);
+
+                for(uint32_t k = 0; k < count; k++) {
+                    uint32_t j = nb[k];
+                    glm::vec3 r = xi - particles.position(j);
+                    float s = this->pairScale(particles, i, j);
+
+                    // W(r) / W(dq) with both at the pair support
+                    float ratio = kernel.poly6(glm::dot(r, r) / (s * s)) / correctionW;
+                    float power = 1.0f;
+                    for(unsigned int e = 0; e < this->correctionN; e++) power *= ratio;
+
+                    float correction = -this->correctionK * power;
+                    delta += particles.mass[j] * (this->lambda[i] + this->lambda[j] + correction) * this->spikyGradient(kernel, particles, i, j);
+                }
+
+                delta = scale * delta + this->lambda[i] * glm::vec3(this->gbx[i], this->gby[i], this->gbz[i]);
+
+                this->dx[i] = delta.x;
+                this->dy[i] = delta.y;
+                this->dz[i] = delta.z;
+            }
+        });
+
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                particles.px[i] = std::clamp(particles.px[i] + this->dx[i], -particles.boxSize, particles.boxSize);
+                particles.py[i] = std::max(particles.py[i] + this->dy[i], 0.0f);
+                particles.pz[i] = std::clamp(particles.pz[i] + this->dz[i], -particles.boxSize, particles.boxSize);
+            }
+        });
+    }
+
+    // v = (x* - x) / dt, expressed as the acceleration the integrator applies to the old velocity
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            particles.ax[i] = ((particles.px[i] - this->x0[i]) / deltaTime - particles.vx[i]) / deltaTime;
+            particles.ay[i] = ((particles.py[i] - this->y0[i]) / deltaTime - particles.vy[i]) / deltaTime - particles.gravity;
+            particles.az[i] = ((particles.pz[i] - this->z0[i]) / deltaTime - particles.vz[i]) / deltaTime;
+        }
+    });
+
+    particles.px.swap(this->x0);
+    particles.py.swap(this->y0);
+    particles.pz.swap(this->z0);
+
+    this->countIterations(this->constraintIterations);
+}
@@ -0,0 +1,142 @@
+#include "../include/pcisph_solver.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PcisphSolver::PcisphSolver(float smoothingRadius, float spacing)
+: Solver(smoothingRadius, spacing),
+  tolerance(PCISPH_TOLERANCE),
+  minIterations(PCISPH_MIN_ITERATIONS),
+  maxIterations(PCISPH_MAX_ITERATIONS),
+  densityError(0.0f) {
+    int reach = (int)std::ceil(this->kernel.h / spacing);
+
+    glm::vec3 sum(0.0f);
+    float sumDot = 0.0f;
+
+    for(int x = -reach; x <= reach; x++) {
+        for(int y = -reach; y <= reach; y++) {
+            for(int z = -reach; z <= reach; z++) {
+                glm::vec3 gradient = this->kernel.spikyGradient(spacing * glm::vec3(x, y, z));
+
+                sum += gradient;
+                sumDot += glm::dot(gradient, gradient);
+            }
+        }
+    }
+
+    this->gradientTerm = glm::dot(sum, sum) + sumDot;
+}
+
+void PcisphSolver::resize(size_t n) {
+    for(AlignedVector<float> *column : { &this->x0, &this->y0, &this->z0, &this->anx, &this->any, &this->anz, &this->apx, &this->apy, &this->apz }) {
+        column->resize(n);
+    }
+}
+
+void PcisphSolver::step(ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool, float deltaTime) {
+    if(this->fixedKernel) this->step(DefaultSphKernel(), this->fixedSimd, particles, neighbours, pool, deltaTime);
+    else this->step(this->kernel, this->simd, particles, neighbours, pool, deltaTime);
+}
+
+template <typename Kernel>
+void PcisphSolver::step(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, ParticleSystem &particles, NeighbourList &neighbours, ThreadPool &pool,
+                        float deltaTime) {
+    const size_t n = particles.size();
+    this->resize(n);
+
+    // scaling factor from the density error to the pressure correction
+    const float beta = 2.0f * (deltaTime * this->particleMass / this->restDensity) * (deltaTime * this->particleMass / this->restDensity);
+    const float delta = 1.0f / (beta * this->gradientTerm);
+
+    // densities at the current positions and the non-pressure accelerations from them
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        this->computeDensity(kernel, simd, particles, neighbours, begin, end);
+        std::fill(particles.pressure.begin() + begin, particles.pressure.begin() + end, 0.0f);
+    });
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ForceSums sums = simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i));
+            glm::vec3 acceleration = this->viscosity * this->particleMass / particles.density[i] * sums.viscosity;
+
+            this->anx[i] = acceleration.x;
+            this->any[i] = acceleration.y;
+            this->anz[i] = acceleration.z;
+            this->apx[i] = this->apy[i] = this->apz[i] = 0.0f;
+        }
+    });
+
+    // the iterations move predicted positions into the position columns so the
+    // kernel loops see them, the originals are swapped back afterwards. the lists
+    // follow the predictions once they move further than the skin covers
+    this->x0.assign(particles.px.begin(), particles.px.end());
+    this->y0.assign(particles.py.begin(), particles.py.end());
+    this->z0.assign(particles.pz.begin(), particles.pz.end());
+
+    unsigned int iteration = 0;
+    this->densityError = 0.0f;
+
+    while(iteration < this->minIterations || (this->densityError > this->tolerance && iteration < this->maxIterations)) {
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                float x = this->x0[i] + deltaTime * (particles.vx[i] + deltaTime * (this->anx[i] + this->apx[i]));
+                float y = this->y0[i] + deltaTime * (particles.vy[i] + deltaTime * (this->any[i] + this->apy[i] + particles.gravity));
+                float z = this->z0[i] + deltaTime * (particles.vz[i] + deltaTime * (this->anz[i] + this->apz[i]));
+
+                // the integrator clamps to the box, predicting past the walls would hide the compression there
+                particles.px[i] = std::clamp(x, -particles.boxSize, particles.boxSize);
+                particles.py[i] = std::max(y, 0.0f);
+                particles.pz[i] = std::clamp(z, -particles.boxSize, particles.boxSize);
+            }
+        });
+
+        this->followPrediction(particles, neighbours, pool);
+
+        this->densityError = pool.parallelReduce(0, n, 0.0f, [&](size_t begin, size_t end) {
+            float partial = 0.0f;
+
+            for(size_t i = begin; i < end; i++) {
+                float predicted = this->particleMass * simd.densitySum(kernel, particles, i, neighbours.begin(i), neighbours.count(i))
+                                + this->boundaryDensity(particles, i);
+                float error = std::max(0.0f, predicted - this->restDensity);
+
+                particles.density[i] = std::max(predicted, this->restDensity);
+                // delta scales with h^2, a split particle needs less pressure per unit of error
+                particles.pressure[i] += delta * particles.smoothing[i] * particles.smoothing[i] * error;
+
+                partial = std::max(partial, error);
+            }
+
+            return partial;
+        }, [](float a, float b) { return std::max(a, b); }) / this->restDensity;
+
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                glm::vec3 acceleration = -this->particleMass * simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i)).pressure
+                                       + this->boundaryPressureAcceleration(particles, i);
+
+                this->apx[i] = acceleration.x;
+                this->apy[i] = acceleration.y;
+                this->apz[i] = acceleration.z;
+            }
+        });
+
+        iteration++;
+    }
+
+    particles.px.swap(this->x0);
+    particles.py.swap(this->y0);
+    particles.pz.swap(this->z0);
+
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            particles.ax[i] = this->anx[i] + this->apx[i];
+            particles.ay[i] = this->any[i] + this->apy[i];
+            particles.az[i] = this->anz[i] + this->apz[i];
+        }
+    });
+
+    this->countIterations(iteration);
+}
@@ -0,0 +1,242 @@
+#include "../include/scenario.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+
+static std::string trim(const std::string &text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if(first == std::string::npos) return "";
+
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+// every parse has to consume the whole value
+template <typename T>
+static bool parseNumbers(const std::string &text, T *values, size_t count) {
+    std::istringstream in(text);
+
+    for(size_t i = 0; i < count; i++) {
+        // istream reads -1 into an unsigned as its largest value
+        if(std::is_unsigned<T>::value && (in >> std::ws).peek() == '-') return false;
+        if(!(in >> values[i])) return false;
+    }
+
+    return (in >> std::ws).eof();
+}
+
+static bool parse(const std::string &text, float &value) { return parseNumbers(text, &value, 1); }
+static bool parse(const std::string &text, unsigned int &value) { return parseNumbers(text, &value, 1); }
+static bool parse(const std::string &text, size_t &value) { return parseNumbers(text, &value, 1); }
+static bool parse(const std::string &text, glm::vec3 &value) { return parseNumbers(text, &value.x, 3); }
+static bool parse(const std::string &text, glm::uvec3 &value) { return parseNumbers(text, &value.x, 3); }
+
+static bool parse(const std::string &text, bool &value) {
+    if(text == "true" || text == "on" || text == "1") value = true;
+    else if(text == "false" || text == "off" || text == "0") value = false;
+    else return false;
+
+    return true;
+}
+
+static bool parse(const std::string &text, Solver_Type &value) {
+    if(text == "wcsph") value = WCSPH;
+    else if(text == "pcisph") value = PCISPH;
+    else if(text == "dfsph") value = DFSPH;
+    else if(text == "iisph") value = IISPH;
+    else if(text == "pbf") value = PBF;
+    else return false;
+
+    return true;
+}
+
+Scenario::Scenario()
+: boxSize(BOX_SIZE),
+  spacing(TRANSLATE),
+  smoothingRadius(SMOOTHING_RADIUS),
+  gravity(GRAVITY),
+  blocks(1, { glm::vec3(0.0f), glm::uvec3(PARTICLE_ROW_COUNT), glm::vec3(0.0f) }),
+  solver(WCSPH),
+  viscosity(VISCOSITY),
+  soundSpeed(SOUND_SPEED),
+  fixedStep(FIXED_TIMESTEP),
+  maxFrameSteps(MAX_FRAME_STEPS),
+  threadCount(THREAD_COUNT),
+  chunkSize(CHUNK_SIZE),
+  adaptive(ADAPTIVE_RESOLUTION),
+  maxParticles(0),
+  sleeping(SLEEPING),
+  collider(COLLIDER) {}
+
+bool Scenario::load(const std::string &path) {
+    std::ifstream file(path);
+
+    if(!file) {
+        std::cout << "ERROR::SCENARIO::FILE_NOT_READ: " << path << std::endl;
+        return false;
+    }
+
+    std::string line, section;
+    unsigned int number = 0;
+
+    bool blocksRead = false, spacingRead = false, radiusRead = false;
+
+    while(std::getline(file, line)) {
+        number++;
+
+        line = trim(line.substr(0, line.find_first_of("#;")));
+        if(line.empty()) continue;
+
+        if(line.front() == '[' && line.back() == ']') {
+            section = trim(line.substr(1, line.size() - 2));
+
+            // the first block of a file replaces the default one
+            if(section == "block") {
+                if(!blocksRead) this->blocks.clear();
+                this->blocks.push_back({ glm::vec3(0.0f), glm::uvec3(0), glm::vec3(0.0f) });
+
+                blocksRead = true;
+            }
+
+            continue;
+        }
+
+        size_t equals = line.find('=');
+
+        if(equals == std::string::npos) {
+            std::cout << "ERROR::SCENARIO::MALFORMED_LINE: " << path << ":" << number << std::endl;
+            return false;
+        }
+
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+
+        bool known = true, parsed = false;
+
+        if(section == "domain") {
+            if(key == "box_size") parsed = parse(value, this->boxSize);
+            else if(key == "spacing") parsed = spacingRead = parse(value, this->spacing);
+            else if(key == "smoothing_radius") parsed = radiusRead = parse(value, this->smoothingRadius);
+            else if(key == "gravity") parsed = parse(value, this->gravity);
+            else known = false;
+        } else if(section == "block") {
+            if(key == "origin") parsed = parse(value, this->blocks.back().origin);
+            else if(key == "count") parsed = parse(value, this->blocks.back().count);
+            else if(key == "velocity") parsed = parse(value, this->blocks.back().velocity);
+            else known = false;
+        } else if(section == "solver") {
+            if(key == "type") parsed = parse(value, this->solver);
+            else if(key == "viscosity") parsed = parse(value, this->viscosity);
+            else if(key == "sound_speed") parsed = parse(value, this->soundSpeed);
+            else if(key == "fixed_step") parsed = parse(value, this->fixedStep);
+            else if(key == "max_frame_steps") parsed = parse(value, this->maxFrameSteps);
+            else known = false;
+        } else if(section == "threads") {
+            if(key == "count") parsed = parse(value, this->threadCount);
+            else if(key == "chunk_size") parsed = parse(value, this->chunkSize);
+            else known = false;
+        } else if(section == "adaptive") {
+            if(key == "enabled") parsed = parse(value, this->adaptive);
+            else if(key == "max_particles") parsed = parse(value, this->maxParticles);
+            else known = false;
+        } else if(section == "sleeping") {
+            if(key == "enabled") parsed = parse(value, this->sleeping);
+            else known = false;
+        } else if(section == "collider") {
+            if(key == "enabled") parsed = parse(value, this->collider);
+            else known = false;
+        } else {
+            known = false;
+        }
+
+        if(!known) {
+            std::cout << "ERROR::SCENARIO::UNKNOWN_KEY: " << path << ":" << number << " [" << section << "] " << key << std::endl;
+            return false;
+        }
+
+        if(!parsed) {
+            std::cout << "ERROR::SCENARIO::BAD_VALUE: " << path << ":" << number << " " << key << " = " << value << std::endl;
+            return false;
+        }
+    }
+
+    if(spacingRead && !radiusRead) this->smoothingRadius = SMOOTHING_FACTOR * this->spacing;
+
+    return this->validate(path);
+}
+
+bool Scenario::validate(const std::string &path) const {
+    std::string problem;
+
+    if(this->boxSize <= 0.0f || this->spacing <= 0.0f || this->smoothingRadius <= 0.0f) problem = "box_size, spacing and smoothing_radius have to be positive";
+    else if(this->fixedStep <= 0.0f || this->maxFrameSteps == 0) problem = "fixed_step and max_frame_steps have to be positive";
+    else if(this->chunkSize == 0) problem = "chunk_size has to be positive";
+    else if(this->particleCount() == 0) problem = "no particles";
+    else if(this->maxParticles != 0 && this->maxParticles < this->particleCount()) problem = "max_particles is below the particle count";
+
+    for(const ParticleBlock &block : this->blocks) {
+        glm::vec3 low = block.origin;
+        glm::vec3 high = block.origin + this->spacing * glm::vec3(glm::max(block.count, glm::uvec3(1)) - 1u);
+
+        if(low.x < -this->boxSize || low.y < 0.0f || low.z < -this->boxSize || glm::any(glm::greaterThan(high, glm::vec3(this->boxSize)))) {
+            problem = "a block reaches outside the box";
+        }
+    }
+
+    if(!problem.empty()) std::cout << "ERROR::SCENARIO::INVALID: " << path << ": " << problem << std::endl;
+
+    return problem.empty();
+}
+
+size_t Scenario::particleCount() const {
+    size_t count = 0;
+    for(const ParticleBlock &block : this->blocks) count += (size_t)block.count.x * block.count.y * block.count.z;
+
+    return count;
+}
+
+// the adaptive budget is kept even while adaptive resolution starts off, it can
+// be switched on at run time
+size_t Scenario::capacity() const {
+    size_t budget = this->maxParticles != 0 ? this->maxParticles : ADAPTIVE_MAX_FACTOR * this->particleCount();
+
+    return std::max(budget, this->particleCount());
+}
+
+float Scenario::verletSkin() const {
+    return VERLET_SKIN_FACTOR * this->smoothingRadius;
+}
+
+float Scenario::particleRadius() const {
+    return PARTICLE_RADIUS_FACTOR * this->spacing;
+}
+
+float Scenario::boundaryOffset() const {
+    return BOUNDARY_OFFSET_FACTOR * this->spacing;
+}
+
+template <typename Real>
+BasicParticleSystem<Real> Scenario::createParticles() const {
+    BasicParticleSystem<Real> particles;
+    particles.gravity = this->gravity;
+    particles.boxSize = this->boxSize;
+    particles.reserve(this->capacity());
+
+    for(const ParticleBlock &block : this->blocks) {
+        for(unsigned int i = 0; i < block.count.x; i++) {
+            for(unsigned int j = 0; j < block.count.y; j++) {
+                for(unsigned int k = 0; k < block.count.z; k++) {
+                    particles.add(glm::vec<3, Real>(block.origin + this->spacing * glm::vec3(i, j, k)), glm::vec<3, Real>(block.velocity));
+                }
+            }
+        }
+    }
+
+    return particles;
+}
+
+template ParticleSystem Scenario::createParticles<float>() const;
+template BasicParticleSystem<double> Scenario::createParticles<double>() const;
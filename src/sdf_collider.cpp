@@ -0,0 +1,290 @@
+#include "../include/sdf_collider.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const uint32_t CACHE_MAGIC = 0x46445353u; // "SSDF"
+const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    int32_t dims[3];
+};
+
+// FNV-1a over raw bytes
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+glm::vec3 closestPoint(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if(d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if(d3 >= 0.0f && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + d1 / (d1 - d3) * ab;
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if(d6 >= 0.0f && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + d2 / (d2 - d6) * ac;
+
+    float va = d3 * d6 - d5 * d4;
+    if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// x where the ray (t, y, z) crosses triangle abc, false when it misses
+bool crossing(float y, float z, glm::vec3 a, glm::vec3 b, glm::vec3 c, float &x) {
+    float wa = (b.y - y) * (c.z - z) - (b.z - z) * (c.y - y);
+    float wb = (c.y - y) * (a.z - z) - (c.z - z) * (a.y - y);
+    float wc = (a.y - y) * (b.z - z) - (a.z - z) * (b.y - y);
+
+    bool positive = wa >= 0.0f && wb >= 0.0f && wc >= 0.0f;
+    bool negative = wa <= 0.0f && wb <= 0.0f && wc <= 0.0f;
+
+    float sum = wa + wb + wc;
+    if((!positive && !negative) || sum == 0.0f) return false;
+
+    x = (wa * a.x + wb * b.x + wc * c.x) / sum;
+    return true;
+}
+
+}
+
+SdfCollider::SdfCollider(const std::vector<glm::vec3> &triangles, float cellSize, float band, ThreadPool &pool, const std::string &cachePath)
+: cellSize(cellSize), band(band), origin(0.0f), dims(1), cached(false), key(14695981039346656037ull) {
+    glm::vec3 low(INFINITY), high(-INFINITY);
+
+    for(const glm::vec3 &corner : triangles) {
+        low = glm::min(low, corner);
+        high = glm::max(high, corner);
+    }
+
+    if(triangles.empty()) low = high = glm::vec3(0.0f);
+
+    // one extra cell around the band keeps the lookup stencil inside the grid
+    glm::vec3 margin(band + cellSize);
+    this->origin = low - margin;
+    this->dims = glm::ivec3(glm::ceil((high - low + 2.0f * margin) / cellSize)) + 1;
+
+    this->key = hashBytes(this->key, triangles.data(), triangles.size() * sizeof(glm::vec3));
+    this->key = hashBytes(this->key, &cellSize, sizeof(float));
+    this->key = hashBytes(this->key, &band, sizeof(float));
+
+    if(!cachePath.empty() && this->load(cachePath)) {
+        this->cached = true;
+        return;
+    }
+
+    this->voxelize(triangles, pool);
+
+    if(!cachePath.empty()) this->save(cachePath);
+}
+
+void SdfCollider::voxelize(const std::vector<glm::vec3> &triangles, ThreadPool &pool) {
+    const int nx = this->dims.x, ny = this->dims.y, nz = this->dims.z;
+    const size_t count = triangles.size() / 3;
+
+    this->phi.assign((size_t)nx * ny * nz, this->band);
+
+    // every triangle goes into the z slices its band reaches
+    std::vector<std::vector<uint32_t>> slices(nz);
+
+    for(size_t t = 0; t < count; t++) {
+        const glm::vec3 *corner = &triangles[3 * t];
+
+        float low = std::min(corner[0].z, std::min(corner[1].z, corner[2].z)) - this->band - this->origin.z;
+        float high = std::max(corner[0].z, std::max(corner[1].z, corner[2].z)) + this->band - this->origin.z;
+
+        int first = std::max(0, (int)std::ceil(low / this->cellSize));
+        int last = std::min(nz - 1, (int)std::floor(high / this->cellSize));
+
+        for(int k = first; k <= last; k++) slices[k].push_back((uint32_t)t);
+    }
+
+    // the rays are nudged off the node rows so they do not run exactly
+    // through the shared edges and corners of a regular mesh
+    const float jitterY = 1.234567e-4f * this->cellSize;
+    const float jitterZ = 0.7654321e-4f * this->cellSize;
+
+    pool.parallelFor(0, nz, [&](size_t begin, size_t end) {
+        std::vector<float> crossings;
+
+        for(size_t k = begin; k < end; k++) {
+            float *slice = this->phi.data() + k * nx * ny;
+            float z = this->origin.z + k * this->cellSize;
+
+            // unsigned distance within the band
+            for(uint32_t t : slices[k]) {
+                glm::vec3 a = triangles[3 * t], b = triangles[3 * t + 1], c = triangles[3 * t + 2];
+
+                glm::vec3 low = (glm::min(a, glm::min(b, c)) - this->band - this->origin) / this->cellSize;
+                glm::vec3 high = (glm::max(a, glm::max(b, c)) + this->band - this->origin) / this->cellSize;
+
+                int x0 = std::max(0, (int)std::ceil(low.x)), x1 = std::min(nx - 1, (int)std::floor(high.x));
+                int y0 = std::max(0, (int)std::ceil(low.y)), y1 = std::min(ny - 1, (int)std::floor(high.y));
+
+                for(int y = y0; y <= y1; y++) {
+                    for(int x = x0; x <= x1; x++) {
+                        glm::vec3 p = this->origin + this->cellSize * glm::vec3(x, y, 0.0f);
+                        p.z = z;
+
+                        float d = glm::length(p - closestPoint(p, a, b, c));
+                        float &value = slice[x + y * nx];
+
+                        value = std::min(value, d);
+                    }
+                }
+            }
+
+            // sign from the parity of the crossings left of each node
+            for(int y = 0; y < ny; y++) {
+                float rayY = this->origin.y + y * this->cellSize + jitterY;
+                float rayZ = z + jitterZ;
+
+                crossings.clear();
+
+                for(uint32_t t : slices[k]) {
+                    float x;
+                    if(crossing(rayY, rayZ, triangles[3 * t], triangles[3 * t + 1], triangles[3 * t + 2], x)) crossings.push_back(x);
+                }
+
+                if(crossings.empty()) continue;
+
+                std::sort(crossings.begin(), crossings.end());
+
+                size_t passed = 0;
+
+                for(int x = 0; x < nx; x++) {
+                    float px = this->origin.x + x * this->cellSize;
+                    while(passed < crossings.size() && crossings[passed] < px) passed++;
+
+                    if(passed & 1) slice[x + y * nx] = -slice[x + y * nx];
+                }
+            }
+        }
+    }, 1);
+}
+
+float SdfCollider::node(int x, int y, int z) const {
+    return this->phi[x + this->dims.x * (y + (size_t)this->dims.y * z)];
+}
+
+float SdfCollider::distance(glm::vec3 position) const {
+    glm::vec3 local = (position - this->origin) / this->cellSize;
+    glm::ivec3 cell = glm::ivec3(glm::floor(local));
+
+    if(glm::any(glm::lessThan(cell, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(cell, this->dims - 1))) return this->band;
+
+    glm::vec3 f = local - glm::vec3(cell);
+
+    float c00 = glm::mix(this->node(cell.x, cell.y, cell.z), this->node(cell.x + 1, cell.y, cell.z), f.x);
+    float c10 = glm::mix(this->node(cell.x, cell.y + 1, cell.z), this->node(cell.x + 1, cell.y + 1, cell.z), f.x);
+    float c01 = glm::mix(this->node(cell.x, cell.y, cell.z + 1), this->node(cell.x + 1, cell.y, cell.z + 1), f.x);
+    float c11 = glm::mix(this->node(cell.x, cell.y + 1, cell.z + 1), this->node(cell.x + 1, cell.y + 1, cell.z + 1), f.x);
+
+    return glm::mix(glm::mix(c00, c10, f.y), glm::mix(c01, c11, f.y), f.z);
+}
+
+glm::vec3 SdfCollider::gradient(glm::vec3 position) const {
+    const float h = 0.5f * this->cellSize;
+
+    return glm::vec3(this->distance(position + glm::vec3(h, 0.0f, 0.0f)) - this->distance(position - glm::vec3(h, 0.0f, 0.0f)),
+                     this->distance(position + glm::vec3(0.0f, h, 0.0f)) - this->distance(position - glm::vec3(0.0f, h, 0.0f)),
+                     this->distance(position + glm::vec3(0.0f, 0.0f, h)) - this->distance(position - glm::vec3(0.0f, 0.0f, h))) / (2.0f * h);
+}
+
+template <typename Real>
+void SdfCollider::collide(BasicParticleSystem<Real> &particles, size_t begin, size_t end, float radius) const {
+    using Vec3 = glm::vec<3, Real>;
+
+    for(size_t i = begin; i < end; i++) {
+        Vec3 position = particles.position(i);
+        float d = this->distance(glm::vec3(position));
+
+        if(d >= radius) continue;
+
+        glm::vec3 gradient = this->gradient(glm::vec3(position));
+        float length = glm::length(gradient);
+
+        // deep inside the band the field is flat and there is no way out
+        if(length < 1e-6f) continue;
+
+        Vec3 normal = Vec3(gradient / length);
+        position += Real(radius - d) * normal;
+
+        Vec3 velocity = particles.velocity(i);
+        Real into = glm::dot(velocity, normal);
+
+        if(into < 0) velocity -= into * normal;
+
+        particles.px[i] = position.x;
+        particles.py[i] = position.y;
+        particles.pz[i] = position.z;
+
+        particles.vx[i] = velocity.x;
+        particles.vy[i] = velocity.y;
+        particles.vz[i] = velocity.z;
+    }
+}
+
+bool SdfCollider::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if(!file || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.key != this->key ||
+       header.dims[0] != this->dims.x || header.dims[1] != this->dims.y || header.dims[2] != this->dims.z) return false;
+
+    this->phi.resize((size_t)this->dims.x * this->dims.y * this->dims.z);
+    file.read(reinterpret_cast<char*>(this->phi.data()), this->phi.size() * sizeof(float));
+
+    return (bool)file;
+}
+
+void SdfCollider::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.key = this->key;
+    header.dims[0] = this->dims.x;
+    header.dims[1] = this->dims.y;
+    header.dims[2] = this->dims.z;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(this->phi.data()), this->phi.size() * sizeof(float));
+
+    if(!file) std::cout << "ERROR::SDF_COLLIDER::CACHE_NOT_WRITTEN: " << path << std::endl;
+}
+
+template void SdfCollider::collide(ParticleSystem&, size_t, size_t, float) const;
+template void SdfCollider::collide(BasicParticleSystem<double>&, size_t, size_t, float) const;
@@ -0,0 +1,614 @@
+#include "../include/simd_kernels.hpp"
+#include "../include/half.hpp"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// the scalar paths run on the kernel's scalar type, they serve float and double stores
+template <typename Kernel, typename Real = typename Kernel::Scalar>
+static Real densityScalar(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    const Real *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+
+    Real sum = 0;
+    for(uint32_t n = 0; n < count; n++) {
+        uint32_t j = neighbours[n];
+
+        Real dx = px[i] - px[j];
+        Real dy = py[i] - py[j];
+        Real dz = pz[i] - pz[j];
+
+        sum += kernel.poly6(dx * dx + dy * dy + dz * dz);
+    }
+
+    return sum;
+}
+
+template <typename Kernel, typename Real = typename Kernel::Scalar>
+static BasicForceSums<Real> forcesScalar(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    using Vec3 = glm::vec<3, Real>;
+
+    BasicForceSums<Real> sums = { Vec3(0), Vec3(0) };
+
+    const Vec3 xi = particles.position(i);
+    const Vec3 vi = particles.velocity(i);
+    const Real pressureTerm = particles.pressure[i] / (particles.density[i] * particles.density[i]);
+
+    for(uint32_t n = 0; n < count; n++) {
+        uint32_t j = neighbours[n];
+        if(j == i) continue;
+
+        Vec3 r = xi - particles.position(j);
+        Real length = glm::length(r);
+        if(length >= kernel.h || length <= 0) continue;
+
+        Real rhoj = particles.density[j];
+
+        sums.pressure += (pressureTerm + particles.pressure[j] / (rhoj * rhoj)) * kernel.spikyGradient(r);
+        sums.viscosity += (particles.velocity(j) - vi) / rhoj * kernel.viscosityLaplacian(length);
+    }
+
+    return sums;
+}
+
+// mixed particle sizes, every pair gets its own support and the sums are
+// weighted by the relative masses of the neighbours
+template <typename Kernel, typename Real = typename Kernel::Scalar>
+static Real densityMixed(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    const Real *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+    const Real *mass = particles.mass.data(), *smoothing = particles.smoothing.data();
+
+    Real sum = 0;
+    for(uint32_t n = 0; n < count; n++) {
+        uint32_t j = neighbours[n];
+
+        Real dx = px[i] - px[j];
+        Real dy = py[i] - py[j];
+        Real dz = pz[i] - pz[j];
+
+        sum += mass[j] * kernel.poly6(dx * dx + dy * dy + dz * dz, Real(0.5) * (smoothing[i] + smoothing[j]));
+    }
+
+    return sum;
+}
+
+template <typename Kernel, typename Real = typename Kernel::Scalar>
+static BasicForceSums<Real> forcesMixed(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    using Vec3 = glm::vec<3, Real>;
+
+    BasicForceSums<Real> sums = { Vec3(0), Vec3(0) };
+
+    const Vec3 xi = particles.position(i);
+    const Vec3 vi = particles.velocity(i);
+    const Real pressureTerm = particles.pressure[i] / (particles.density[i] * particles.density[i]);
+
+    for(uint32_t n = 0; n < count; n++) {
+        uint32_t j = neighbours[n];
+        if(j == i) continue;
+
+        Real s = Real(0.5) * (particles.smoothing[i] + particles.smoothing[j]);
+
+        Vec3 r = xi - particles.position(j);
+        Real length = glm::length(r);
+        if(length >= s * kernel.h || length <= 0) continue;
+
+        Real rhoj = particles.density[j];
+        Real mj = particles.mass[j];
+
+        sums.pressure += mj * (pressureTerm + particles.pressure[j] / (rhoj * rhoj)) * kernel.spikyGradient(r, s);
+        sums.viscosity += mj * (particles.velocity(j) - vi) / rhoj * kernel.viscosityLaplacian(length, s);
+    }
+
+    return sums;
+}
+
+// the records are fp16 whatever the store holds
+template <typename Real>
+static void packScalar(const BasicParticleSystem<Real> &particles, size_t begin, size_t end, uint32_t *packed) {
+    for(size_t i = begin; i < end; i++) {
+        float density = (float)particles.density[i];
+        float inverseDensity = density > 0.0f ? 1.0f / density : 0.0f;
+
+        uint32_t *record = packed + SimdKernels::PACKED_WORDS * i;
+        record[0] = packHalves((float)particles.vx[i], (float)particles.vy[i]);
+        record[1] = packHalves((float)particles.vz[i], (float)particles.pressure[i] * inverseDensity * inverseDensity);
+        record[2] = packHalves(inverseDensity, 0.0f);
+    }
+}
+
+template <typename Kernel, typename Real = typename Kernel::Scalar>
+static BasicForceSums<Real> forcesPackedScalar(const Kernel &kernel, const BasicParticleSystem<Real> &particles, const uint32_t *packed, size_t i,
+                                               const uint32_t *neighbours, uint32_t count) {
+    using Vec3 = glm::vec<3, Real>;
+
+    BasicForceSums<Real> sums = { Vec3(0), Vec3(0) };
+
+    const Vec3 xi = particles.position(i);
+    const Vec3 vi = particles.velocity(i);
+    const Real pressureTerm = particles.pressure[i] / (particles.density[i] * particles.density[i]);
+
+    for(uint32_t n = 0; n < count; n++) {
+        uint32_t j = neighbours[n];
+        if(j == i) continue;
+
+        Vec3 r = xi - particles.position(j);
+        Real length = glm::length(r);
+        if(length >= kernel.h || length <= 0) continue;
+
+        const uint32_t *record = packed + SimdKernels::PACKED_WORDS * j;
+        Vec3 vj(fromHalf(record[0] & 0xffff), fromHalf(record[0] >> 16), fromHalf(record[1] & 0xffff));
+
+        sums.pressure += (pressureTerm + Real(fromHalf(record[1] >> 16))) * kernel.spikyGradient(r);
+        sums.viscosity += (vj - vi) * Real(fromHalf(record[2] & 0xffff)) * kernel.viscosityLaplacian(length);
+    }
+
+    return sums;
+}
+
+__attribute__((target("avx2,fma")))
+static inline float horizontalSum(__m256 v) {
+    __m128 low = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    low = _mm_add_ps(low, _mm_movehl_ps(low, low));
+    low = _mm_add_ss(low, _mm_shuffle_ps(low, low, 1));
+
+    return _mm_cvtss_f32(low);
+}
+
+// lanes [0, left) set, the tail of a neighbour list is loaded and gathered under it
+__attribute__((target("avx2,fma")))
+static inline __m256i laneMask(uint32_t left) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)std::min(left, 8u)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 gather(const float *base, __m256i index, __m256 mask) {
+    return _mm256_mask_i32gather_ps(_mm256_setzero_ps(), base, index, mask, 4);
+}
+
+template <typename Kernel>
+__attribute__((target("avx2,fma")))
+static float densityAvx2(const Kernel &kernel, const ParticleSystem &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    const float *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+
+    const __m256 xi = _mm256_set1_ps(px[i]), yi = _mm256_set1_ps(py[i]), zi = _mm256_set1_ps(pz[i]);
+    const __m256 h2 = _mm256_set1_ps(kernel.h2);
+
+    __m256 sum = _mm256_setzero_ps();
+
+    for(uint32_t n = 0; n < count; n += 8) {
+        __m256i lanes = laneMask(count - n);
+        __m256 mask = _mm256_castsi256_ps(lanes);
+        __m256i index = _mm256_maskload_epi32((const int*)(neighbours + n), lanes);
+
+        __m256 dx = _mm256_sub_ps(xi, gather(px, index, mask));
+        __m256 dy = _mm256_sub_ps(yi, gather(py, index, mask));
+        __m256 dz = _mm256_sub_ps(zi, gather(pz, index, mask));
+
+        __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+        __m256 t = _mm256_sub_ps(h2, r2);
+        __m256 w = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ));
+        sum = _mm256_add_ps(sum, _mm256_and_ps(w, mask));
+    }
+
+    return kernel.poly6Coefficient * horizontalSum(sum);
+}
+
+template <typename Kernel>
+__attribute__((target("avx2,fma")))
+static ForceSums forcesAvx2(const Kernel &kernel, const ParticleSystem &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    const float *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+    const float *vx = particles.vx.data(), *vy = particles.vy.data(), *vz = particles.vz.data();
+    const float *density = particles.density.data(), *pressure = particles.pressure.data();
+
+    const __m256 xi = _mm256_set1_ps(px[i]), yi = _mm256_set1_ps(py[i]), zi = _mm256_set1_ps(pz[i]);
+    const __m256 vxi = _mm256_set1_ps(vx[i]), vyi = _mm256_set1_ps(vy[i]), vzi = _mm256_set1_ps(vz[i]);
+    const __m256 pressureTerm = _mm256_set1_ps(pressure[i] / (density[i] * density[i]));
+    const __m256 h = _mm256_set1_ps(kernel.h), h2 = _mm256_set1_ps(kernel.h2);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+
+    __m256 fpx = zero, fpy = zero, fpz = zero;
+    __m256 fvx = zero, fvy = zero, fvz = zero;
+
+    for(uint32_t n = 0; n < count; n += 8) {
+        __m256i lanes = laneMask(count - n);
+        __m256 mask = _mm256_castsi256_ps(lanes);
+        __m256i index = _mm256_maskload_epi32((const int*)(neighbours + n), lanes);
+
+        __m256 dx = _mm256_sub_ps(xi, gather(px, index, mask));
+        __m256 dy = _mm256_sub_ps(yi, gather(py, index, mask));
+        __m256 dz = _mm256_sub_ps(zi, gather(pz, index, mask));
+        __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+
+        // inside the support and not the particle itself
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ));
+
+        // masked lanes get r = 1 and rho = 1 so nothing below divides by zero
+        __m256 r = _mm256_blendv_ps(one, _mm256_sqrt_ps(r2), mask);
+        __m256 rhoj = _mm256_blendv_ps(one, gather(density, index, mask), mask);
+        __m256 pj = gather(pressure, index, mask);
+        __m256 invRhoj = _mm256_div_ps(one, rhoj);
+
+        __m256 t = _mm256_and_ps(_mm256_sub_ps(h, r), mask);
+
+        // (p_i / rho_i^2 + p_j / rho_j^2) * c * (h - r)^2 / r
+        __m256 scale = _mm256_fmadd_ps(pj, _mm256_mul_ps(invRhoj, invRhoj), pressureTerm);
+        scale = _mm256_mul_ps(scale, _mm256_div_ps(_mm256_mul_ps(t, t), r));
+
+        fpx = _mm256_fmadd_ps(scale, dx, fpx);
+        fpy = _mm256_fmadd_ps(scale, dy, fpy);
+        fpz = _mm256_fmadd_ps(scale, dz, fpz);
+
+        // (h - r) / rho_j, the laplacian coefficient is applied once at the end
+        __m256 weight = _mm256_mul_ps(t, invRhoj);
+
+        fvx = _mm256_fmadd_ps(weight, _mm256_sub_ps(gather(vx, index, mask), vxi), fvx);
+        fvy = _mm256_fmadd_ps(weight, _mm256_sub_ps(gather(vy, index, mask), vyi), fvy);
+        fvz = _mm256_fmadd_ps(weight, _mm256_sub_ps(gather(vz, index, mask), vzi), fvz);
+    }
+
+    ForceSums sums;
+    sums.pressure = kernel.spikyGradientCoefficient * glm::vec3(horizontalSum(fpx), horizontalSum(fpy), horizontalSum(fpz));
+    sums.viscosity = kernel.viscosityLaplacianCoefficient * glm::vec3(horizontalSum(fvx), horizontalSum(fvy), horizontalSum(fvz));
+
+    return sums;
+}
+
+// the low and the high halves of eight words, widened to floats
+__attribute__((target("avx2,fma,f16c")))
+static inline __m256 lowHalves(__m256i words) {
+    __m256i low = _mm256_and_si256(words, _mm256_set1_epi32(0xffff));
+    return _mm256_cvtph_ps(_mm_packus_epi32(_mm256_castsi256_si128(low), _mm256_extracti128_si256(low, 1)));
+}
+
+__attribute__((target("avx2,fma,f16c")))
+static inline __m256 highHalves(__m256i words) {
+    __m256i high = _mm256_srli_epi32(words, 16);
+    return _mm256_cvtph_ps(_mm_packus_epi32(_mm256_castsi256_si128(high), _mm256_extracti128_si256(high, 1)));
+}
+
+// eight particles at a time, the interleaved words go through a small buffer
+// into the records
+__attribute__((target("avx2,fma,f16c")))
+static void packAvx2(const ParticleSystem &particles, size_t begin, size_t end, uint32_t *packed) {
+    const float *vx = particles.vx.data(), *vy = particles.vy.data(), *vz = particles.vz.data();
+    const float *density = particles.density.data(), *pressure = particles.pressure.data();
+
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const int rounding = _MM_FROUND_TO_NEAREST_INT;
+
+    alignas(32) uint32_t words[SimdKernels::PACKED_WORDS][8];
+
+    size_t i = begin;
+
+    for(; i + 8 <= end; i += 8) {
+        __m256 rho = _mm256_loadu_ps(density + i);
+        __m256 inverse = _mm256_and_ps(_mm256_div_ps(one, rho), _mm256_cmp_ps(rho, zero, _CMP_GT_OQ));
+        // (p / rho) / rho in the order of packScalar, so both write the same records
+        __m256 term = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(pressure + i), inverse), inverse);
+
+        __m128i hx = _mm256_cvtps_ph(_mm256_loadu_ps(vx + i), rounding);
+        __m128i hy = _mm256_cvtps_ph(_mm256_loadu_ps(vy + i), rounding);
+        __m128i hz = _mm256_cvtps_ph(_mm256_loadu_ps(vz + i), rounding);
+        __m128i hp = _mm256_cvtps_ph(term, rounding);
+        __m128i hr = _mm256_cvtps_ph(inverse, rounding);
+
+        _mm_store_si128((__m128i*)words[0], _mm_unpacklo_epi16(hx, hy));
+        _mm_store_si128((__m128i*)(words[0] + 4), _mm_unpackhi_epi16(hx, hy));
+        _mm_store_si128((__m128i*)words[1], _mm_unpacklo_epi16(hz, hp));
+        _mm_store_si128((__m128i*)(words[1] + 4), _mm_unpackhi_epi16(hz, hp));
+        _mm_store_si128((__m128i*)words[2], _mm_unpacklo_epi16(hr, _mm_setzero_si128()));
+        _mm_store_si128((__m128i*)(words[2] + 4), _mm_unpackhi_epi16(hr, _mm_setzero_si128()));
+
+        uint32_t *record = packed + SimdKernels::PACKED_WORDS * i;
+
+        for(size_t k = 0; k < 8; k++) {
+            record[0] = words[0][k];
+            record[1] = words[1][k];
+            record[2] = words[2][k];
+            record += SimdKernels::PACKED_WORDS;
+        }
+    }
+
+    packScalar(particles, i, end, packed);
+}
+
+template <typename Kernel>
+__attribute__((target("avx2,fma,f16c")))
+static ForceSums forcesPackedAvx2(const Kernel &kernel, const ParticleSystem &particles, const uint32_t *packed, size_t i, const uint32_t *neighbours,
+                                  uint32_t count) {
+    const float *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+    const int *records = (const int*)packed;
+
+    const __m256 xi = _mm256_set1_ps(px[i]), yi = _mm256_set1_ps(py[i]), zi = _mm256_set1_ps(pz[i]);
+    const __m256 vxi = _mm256_set1_ps(particles.vx[i]), vyi = _mm256_set1_ps(particles.vy[i]), vzi = _mm256_set1_ps(particles.vz[i]);
+    const __m256 pressureTerm = _mm256_set1_ps(particles.pressure[i] / (particles.density[i] * particles.density[i]));
+    const __m256 h = _mm256_set1_ps(kernel.h), h2 = _mm256_set1_ps(kernel.h2);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+
+    __m256 fpx = zero, fpy = zero, fpz = zero;
+    __m256 fvx = zero, fvy = zero, fvz = zero;
+
+    for(uint32_t n = 0; n < count; n += 8) {
+        __m256i lanes = laneMask(count - n);
+        __m256 mask = _mm256_castsi256_ps(lanes);
+        __m256i index = _mm256_maskload_epi32((const int*)(neighbours + n), lanes);
+
+        __m256 dx = _mm256_sub_ps(xi, gather(px, index, mask));
+        __m256 dy = _mm256_sub_ps(yi, gather(py, index, mask));
+        __m256 dz = _mm256_sub_ps(zi, gather(pz, index, mask));
+        __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(r2, h2, _CMP_LT_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ));
+
+        // masked lanes gather zero words, which widen to zero
+        __m256i record = _mm256_add_epi32(_mm256_slli_epi32(index, 1), index);
+        __m256i lanesIn = _mm256_castps_si256(mask);
+        __m256i w0 = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), records, record, lanesIn, 4);
+        __m256i w1 = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), records + 1, record, lanesIn, 4);
+        __m256i w2 = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), records + 2, record, lanesIn, 4);
+
+        __m256 r = _mm256_blendv_ps(one, _mm256_sqrt_ps(r2), mask);
+        __m256 t = _mm256_and_ps(_mm256_sub_ps(h, r), mask);
+
+        __m256 scale = _mm256_add_ps(highHalves(w1), pressureTerm);
+        scale = _mm256_mul_ps(scale, _mm256_div_ps(_mm256_mul_ps(t, t), r));
+
+        fpx = _mm256_fmadd_ps(scale, dx, fpx);
+        fpy = _mm256_fmadd_ps(scale, dy, fpy);
+        fpz = _mm256_fmadd_ps(scale, dz, fpz);
+
+        __m256 weight = _mm256_mul_ps(t, lowHalves(w2));
+
+        fvx = _mm256_fmadd_ps(weight, _mm256_sub_ps(lowHalves(w0), vxi), fvx);
+        fvy = _mm256_fmadd_ps(weight, _mm256_sub_ps(highHalves(w0), vyi), fvy);
+        fvz = _mm256_fmadd_ps(weight, _mm256_sub_ps(lowHalves(w1), vzi), fvz);
+    }
+
+    ForceSums sums;
+    sums.pressure = kernel.spikyGradientCoefficient * glm::vec3(horizontalSum(fpx), horizontalSum(fpy), horizontalSum(fpz));
+    sums.viscosity = kernel.viscosityLaplacianCoefficient * glm::vec3(horizontalSum(fvx), horizontalSum(fvy), horizontalSum(fvz));
+
+    return sums;
+}
+
+template <typename Kernel>
+__attribute__((target("avx512f")))
+static float densityAvx512(const Kernel &kernel, const ParticleSystem &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    const float *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+
+    const __m512 xi = _mm512_set1_ps(px[i]), yi = _mm512_set1_ps(py[i]), zi = _mm512_set1_ps(pz[i]);
+    const __m512 h2 = _mm512_set1_ps(kernel.h2);
+    const __m512 zero = _mm512_setzero_ps();
+
+    __m512 sum = zero;
+
+    for(uint32_t n = 0; n < count; n += 16) {
+        uint32_t left = count - n;
+        __mmask16 mask = left >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << left) - 1);
+        __m512i index = _mm512_maskz_loadu_epi32(mask, neighbours + n);
+
+        __m512 dx = _mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, mask, index, px, 4));
+        __m512 dy = _mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, mask, index, py, 4));
+        __m512 dz = _mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, mask, index, pz, 4));
+
+        __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+        __m512 t = _mm512_sub_ps(h2, r2);
+
+        mask = _mm512_mask_cmp_ps_mask(mask, r2, h2, _CMP_LT_OQ);
+        sum = _mm512_mask_add_ps(sum, mask, sum, _mm512_mul_ps(_mm512_mul_ps(t, t), t));
+    }
+
+    return kernel.poly6Coefficient * _mm512_reduce_add_ps(sum);
+}
+
+template <typename Kernel>
+__attribute__((target("avx512f")))
+static ForceSums forcesAvx512(const Kernel &kernel, const ParticleSystem &particles, size_t i, const uint32_t *neighbours, uint32_t count) {
+    const float *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+    const float *vx = particles.vx.data(), *vy = particles.vy.data(), *vz = particles.vz.data();
+    const float *density = particles.density.data(), *pressure = particles.pressure.data();
+
+    const __m512 xi = _mm512_set1_ps(px[i]), yi = _mm512_set1_ps(py[i]), zi = _mm512_set1_ps(pz[i]);
+    const __m512 vxi = _mm512_set1_ps(vx[i]), vyi = _mm512_set1_ps(vy[i]), vzi = _mm512_set1_ps(vz[i]);
+    const __m512 pressureTerm = _mm512_set1_ps(pressure[i] / (density[i] * density[i]));
+    const __m512 h = _mm512_set1_ps(kernel.h), h2 = _mm512_set1_ps(kernel.h2);
+    const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f);
+
+    __m512 fpx = zero, fpy = zero, fpz = zero;
+    __m512 fvx = zero, fvy = zero, fvz = zero;
+
+    for(uint32_t n = 0; n < count; n += 16) {
+        uint32_t left = count - n;
+        __mmask16 mask = left >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << left) - 1);
+        __m512i index = _mm512_maskz_loadu_epi32(mask, neighbours + n);
+
+        __m512 dx = _mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, mask, index, px, 4));
+        __m512 dy = _mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, mask, index, py, 4));
+        __m512 dz = _mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, mask, index, pz, 4));
+        __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+
+        // inside the support and not the particle itself
+        mask = _mm512_mask_cmp_ps_mask(mask, r2, h2, _CMP_LT_OQ);
+        mask = _mm512_mask_cmp_ps_mask(mask, r2, zero, _CMP_GT_OQ);
+
+        // masked lanes keep r = 1 and rho = 1 so nothing below divides by zero
+        __m512 r = _mm512_mask_sqrt_ps(one, mask, r2);
+        __m512 rhoj = _mm512_mask_i32gather_ps(one, mask, index, density, 4);
+        __m512 pj = _mm512_mask_i32gather_ps(zero, mask, index, pressure, 4);
+        __m512 invRhoj = _mm512_div_ps(one, rhoj);
+
+        __m512 t = _mm512_maskz_sub_ps(mask, h, r);
+
+        __m512 scale = _mm512_fmadd_ps(pj, _mm512_mul_ps(invRhoj, invRhoj), pressureTerm);
+        scale = _mm512_mul_ps(scale, _mm512_div_ps(_mm512_mul_ps(t, t), r));
+
+        fpx = _mm512_fmadd_ps(scale, dx, fpx);
+        fpy = _mm512_fmadd_ps(scale, dy, fpy);
+        fpz = _mm512_fmadd_ps(scale, dz, fpz);
+
+        __m512 weight = _mm512_mul_ps(t, invRhoj);
+
+        fvx = _mm512_fmadd_ps(weight, _mm512_sub_ps(_mm512_mask_i32gather_ps(zero, mask, index, vx, 4), vxi), fvx);
+        fvy = _mm512_fmadd_ps(weight, _mm512_sub_ps(_mm512_mask_i32gather_ps(zero, mask, index, vy, 4), vyi), fvy);
+        fvz = _mm512_fmadd_ps(weight, _mm512_sub_ps(_mm512_mask_i32gather_ps(zero, mask, index, vz, 4), vzi), fvz);
+    }
+
+    ForceSums sums;
+    sums.pressure = kernel.spikyGradientCoefficient * glm::vec3(_mm512_reduce_add_ps(fpx), _mm512_reduce_add_ps(fpy), _mm512_reduce_add_ps(fpz));
+    sums.viscosity = kernel.viscosityLaplacianCoefficient * glm::vec3(_mm512_reduce_add_ps(fvx), _mm512_reduce_add_ps(fvy), _mm512_reduce_add_ps(fvz));
+
+    return sums;
+}
+
+// vpmovdw keeps the low 16 bits of every word
+__attribute__((target("avx512f")))
+static inline __m512 lowHalves(__m512i words) {
+    return _mm512_cvtph_ps(_mm512_cvtepi32_epi16(words));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 highHalves(__m512i words) {
+    return _mm512_cvtph_ps(_mm512_cvtepi32_epi16(_mm512_srli_epi32(words, 16)));
+}
+
+template <typename Kernel>
+__attribute__((target("avx512f")))
+static ForceSums forcesPackedAvx512(const Kernel &kernel, const ParticleSystem &particles, const uint32_t *packed, size_t i, const uint32_t *neighbours,
+                                    uint32_t count) {
+    const float *px = particles.px.data(), *py = particles.py.data(), *pz = particles.pz.data();
+
+    const __m512 xi = _mm512_set1_ps(px[i]), yi = _mm512_set1_ps(py[i]), zi = _mm512_set1_ps(pz[i]);
+    const __m512 vxi = _mm512_set1_ps(particles.vx[i]), vyi = _mm512_set1_ps(particles.vy[i]), vzi = _mm512_set1_ps(particles.vz[i]);
+    const __m512 pressureTerm = _mm512_set1_ps(particles.pressure[i] / (particles.density[i] * particles.density[i]));
+    const __m512 h = _mm512_set1_ps(kernel.h), h2 = _mm512_set1_ps(kernel.h2);
+    const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f);
+    const __m512i none = _mm512_setzero_si512();
+
+    __m512 fpx = zero, fpy = zero, fpz = zero;
+    __m512 fvx = zero, fvy = zero, fvz = zero;
+
+    for(uint32_t n = 0; n < count; n += 16) {
+        uint32_t left = count - n;
+        __mmask16 mask = left >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << left) - 1);
+        __m512i index = _mm512_maskz_loadu_epi32(mask, neighbours + n);
+
+        __m512 dx = _mm512_sub_ps(xi, _mm512_mask_i32gather_ps(zero, mask, index, px, 4));
+        __m512 dy = _mm512_sub_ps(yi, _mm512_mask_i32gather_ps(zero, mask, index, py, 4));
+        __m512 dz = _mm512_sub_ps(zi, _mm512_mask_i32gather_ps(zero, mask, index, pz, 4));
+        __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+
+        mask = _mm512_mask_cmp_ps_mask(mask, r2, h2, _CMP_LT_OQ);
+        mask = _mm512_mask_cmp_ps_mask(mask, r2, zero, _CMP_GT_OQ);
+
+        __m512i record = _mm512_add_epi32(_mm512_slli_epi32(index, 1), index);
+        __m512i w0 = _mm512_mask_i32gather_epi32(none, mask, record, packed, 4);
+        __m512i w1 = _mm512_mask_i32gather_epi32(none, mask, record, packed + 1, 4);
+        __m512i w2 = _mm512_mask_i32gather_epi32(none, mask, record, packed + 2, 4);
+
+        __m512 r = _mm512_mask_sqrt_ps(one, mask, r2);
+        __m512 t = _mm512_maskz_sub_ps(mask, h, r);
+
+        __m512 scale = _mm512_add_ps(highHalves(w1), pressureTerm);
+        scale = _mm512_mul_ps(scale, _mm512_div_ps(_mm512_mul_ps(t, t), r));
+
+        fpx = _mm512_fmadd_ps(scale, dx, fpx);
+        fpy = _mm512_fmadd_ps(scale, dy, fpy);
+        fpz = _mm512_fmadd_ps(scale, dz, fpz);
+
+        __m512 weight = _mm512_mul_ps(t, lowHalves(w2));
+
+        fvx = _mm512_fmadd_ps(weight, _mm512_sub_ps(lowHalves(w0), vxi), fvx);
+        fvy = _mm512_fmadd_ps(weight, _mm512_sub_ps(highHalves(w0), vyi), fvy);
+        fvz = _mm512_fmadd_ps(weight, _mm512_sub_ps(lowHalves(w1), vzi), fvz);
+    }
+
+    ForceSums sums;
+    sums.pressure = kernel.spikyGradientCoefficient * glm::vec3(_mm512_reduce_add_ps(fpx), _mm512_reduce_add_ps(fpy), _mm512_reduce_add_ps(fpz));
+    sums.viscosity = kernel.viscosityLaplacianCoefficient * glm::vec3(_mm512_reduce_add_ps(fvx), _mm512_reduce_add_ps(fvy), _mm512_reduce_add_ps(fvz));
+
+    return sums;
+}
+
+template <typename Kernel>
+Simd_Level BasicSimdKernels<Kernel>::detect() {
+    __builtin_cpu_init();
+
+    // the AVX-512 level packs its records with packAvx2, so it needs the AVX2 set as well
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+
+    if(avx2 && __builtin_cpu_supports("avx512f")) return AVX512;
+    if(avx2) return AVX2;
+
+    return SCALAR;
+}
+
+template <typename Kernel>
+BasicSimdKernels<Kernel>::BasicSimdKernels(Simd_Level level) {
+    // the vector paths work on float columns
+    this->simdLevel = std::is_same<Real, float>::value ? std::min(level, detect()) : SCALAR;
+
+    this->density = densityScalar;
+    this->forces = forcesScalar;
+    this->packer = packScalar;
+    this->packedForces = forcesPackedScalar;
+
+    if constexpr(std::is_same<Real, float>::value) {
+        switch(this->simdLevel) {
+            case AVX512:
+                this->density = densityAvx512;
+                this->forces = forcesAvx512;
+                this->packer = packAvx2;
+                this->packedForces = forcesPackedAvx512;
+                break;
+            case AVX2:
+                this->density = densityAvx2;
+                this->forces = forcesAvx2;
+                this->packer = packAvx2;
+                this->packedForces = forcesPackedAvx2;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+template <typename Kernel>
+typename BasicSimdKernels<Kernel>::Real BasicSimdKernels<Kernel>::densitySum(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i,
+                                                                             const uint32_t *neighbours, uint32_t count) const {
+    if(particles.mixedSizes) return densityMixed(kernel, particles, i, neighbours, count);
+
+    return this->density(kernel, particles, i, neighbours, count);
+}
+
+template <typename Kernel>
+BasicForceSums<typename Kernel::Scalar> BasicSimdKernels<Kernel>::forceSums(const Kernel &kernel, const BasicParticleSystem<Real> &particles, size_t i,
+                                                                            const uint32_t *neighbours, uint32_t count) const {
+    if(particles.mixedSizes) return forcesMixed(kernel, particles, i, neighbours, count);
+
+    return this->forces(kernel, particles, i, neighbours, count);
+}
+
+template <typename Kernel>
+void BasicSimdKernels<Kernel>::pack(const BasicParticleSystem<Real> &particles, size_t begin, size_t end, uint32_t *packed) const {
+    this->packer(particles, begin, end, packed);
+}
+
+// the records carry no masses or supports, mixed sizes take the full precision path
+template <typename Kernel>
+BasicForceSums<typename Kernel::Scalar> BasicSimdKernels<Kernel>::forceSums(const Kernel &kernel, const BasicParticleSystem<Real> &particles, const uint32_t *packed,
+                                                                            size_t i, const uint32_t *neighbours, uint32_t count) const {
+    if(particles.mixedSizes) return forcesMixed(kernel, particles, i, neighbours, count);
+
+    return this->packedForces(kernel, particles, packed, i, neighbours, count);
+}
+
+template class BasicSimdKernels<SphKernel>;
+template class BasicSimdKernels<DefaultSphKernel>;
+template class BasicSimdKernels<BasicSphKernel<double>>;
+template class BasicSimdKernels<BasicDefaultSphKernel<double>>;
@@ -0,0 +1,189 @@
+#include "../include/simulation.hpp"
+#include "../include/constants.hpp"
+#include "../include/dfsph_solver.hpp"
+#include "../include/iisph_solver.hpp"
+#include "../include/pbf_solver.hpp"
+#include "../include/pcisph_solver.hpp"
+#include "../include/wcsph_solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+template <typename Real>
+BasicSimulation<Real>::BasicSimulation(const Scenario &scenario)
+: scenario(scenario),
+  pool(scenario.threadCount, scenario.chunkSize),
+  particles(scenario.createParticles<Real>()),
+  grid(scenario.smoothingRadius + scenario.verletSkin(), glm::vec3(-scenario.boxSize, 0.0f, -scenario.boxSize), glm::vec3(scenario.boxSize)),
+  neighbours(scenario.smoothingRadius, scenario.capacity(), scenario.verletSkin(), NEIGHBOUR_RESERVE),
+  boundary(scenario.spacing, scenario.boundaryOffset(), glm::vec3(-scenario.boxSize, 0.0f, -scenario.boxSize), glm::vec3(scenario.boxSize),
+           BasicSphKernel<Real>(scenario.smoothingRadius), REST_DENSITY, scenario.verletSkin(), scenario.capacity(), this->pool),
+  timestep(scenario.smoothingRadius, CFL_FACTOR, FORCE_FACTOR, MIN_TIMESTEP, MAX_TIMESTEP),
+  adaptive(scenario.smoothingRadius, scenario.spacing, ADAPTIVE_MIN_MASS, scenario.capacity(), ADAPTIVE_SURFACE_DENSITY, ADAPTIVE_INTERIOR_DENSITY,
+           ADAPTIVE_CALM_SPEED, ADAPTIVE_FOCUS_FACTOR * scenario.boxSize, ADAPTIVE_INTERVAL),
+  sleeping(SLEEP_SPEED, SLEEP_DENSITY_CHANGE, SLEEP_STEPS),
+  fixedStep(scenario.fixedStep),
+  maxSteps(scenario.maxFrameSteps),
+  timeScale(1.0f),
+  steps(0),
+  substeps(0),
+  alpha(1.0f),
+  deltaTime(0.0f),
+  previousDeltaTime(0.0f),
+  accumulator(0.0f) {
+    // the particle columns come reserved for the capacity, splits append within
+    // it. everything else holding per-particle state is reserved for it as well,
+    // so neither a reorder nor a split allocates during the run
+    this->adaptive.enabled = scenario.adaptive;
+    this->sleeping.enabled = scenario.sleeping;
+    this->grid.reserve(scenario.capacity());
+    this->adaptive.reserve(scenario.capacity());
+    this->sleeping.reserve(scenario.capacity());
+    this->modelMatrices.reserve(scenario.capacity());
+    this->modelMatrices.resize(this->particles.size());
+
+    // WCSPH runs under every integrator
+    if(!this->setSolver(scenario.solver)) this->setSolver(WCSPH);
+}
+
+// null for a solver that does not run on a store of Real, the iterative ones are float only
+template <typename Real>
+static BasicSolver<Real>* createSolver(Solver_Type type, const Scenario &scenario) {
+    if constexpr(std::is_same<Real, float>::value) {
+        switch(type) {
+            case DFSPH:
+                return new DfsphSolver(scenario.smoothingRadius, scenario.spacing);
+            case IISPH:
+                return new IisphSolver(scenario.smoothingRadius, scenario.spacing);
+            case PBF:
+                return new PbfSolver(scenario.smoothingRadius, scenario.spacing);
+            case PCISPH:
+                return new PcisphSolver(scenario.smoothingRadius, scenario.spacing);
+            default:
+                break;
+        }
+    } else if(type != WCSPH) {
+        return nullptr;
+    }
+
+    return new BasicWcsphSolver<Real>(scenario.smoothingRadius, scenario.spacing, scenario.soundSpeed);
+}
+
+template <typename Real>
+bool BasicSimulation<Real>::setSolver(Solver_Type type) {
+    std::unique_ptr<BasicSolver<Real>> solver(createSolver<Real>(type, this->scenario));
+
+    if(!solver) {
+        std::cout << "ERROR::SIMULATION::SOLVER_PRECISION: the iterative solvers only run on a float store, WCSPH runs on both" << std::endl;
+        return false;
+    }
+
+    if(solver->requiresEuler() && !std::is_same<SimulationIntegrator, SemiImplicitEuler>::value) {
+        std::cout << "ERROR::SIMULATION::SOLVER_NEEDS_EULER: " << solver->name() << " only runs with SimulationIntegrator = SemiImplicitEuler" << std::endl;
+        return false;
+    }
+
+    // split particles would stay in the store, pausing adaptive resolution does not remove them
+    if(this->particles.mixedSizes && !solver->mixedSizes()) {
+        std::cout << "ERROR::SIMULATION::MIXED_SIZES: " << solver->name() << " does not run on split particles, the store has to be back at one size first" << std::endl;
+        return false;
+    }
+
+    this->solver = std::move(solver);
+
+    this->solver->viscosity = this->scenario.viscosity;
+    this->solver->boundary = &this->boundary;
+    this->solver->grid = &this->grid;
+    this->solver->sleeping = &this->sleeping;
+    this->solver->reserve(this->scenario.capacity());
+
+    this->buildGraph();
+
+    return true;
+}
+
+template <typename Real>
+void BasicSimulation<Real>::buildGraph() {
+    const size_t n = this->particles.size();
+    const size_t chunk = this->pool.chunkSize;
+
+    this->graph.clear();
+
+    size_t neighbourTask = this->graph.add([this] {
+        if(this->neighbours.update(this->particles, this->grid, this->pool)) this->boundary.update(this->particles, this->pool);
+    });
+    size_t sleepTask = this->graph.add([this] { this->sleeping.update(this->particles, this->grid, this->solver->restDensity, this->pool); });
+    this->graph.precede(neighbourTask, sleepTask);
+
+    size_t solverTask = this->solver->addTasks(this->graph, this->particles, this->neighbours, this->pool, this->deltaTime, sleepTask);
+
+    for(size_t begin = 0; begin < n; begin += chunk) {
+        size_t end = std::min(begin + chunk, n);
+
+        size_t integrateTask = this->graph.add([this, begin, end] {
+            this->sleeping.forEachAwake(begin, end, [this](size_t b, size_t e) {
+                this->particles.template integrate<SimulationIntegrator>(b, e, this->deltaTime, this->previousDeltaTime);
+
+                for(const SdfCollider &collider : this->colliders) collider.collide(this->particles, b, e, this->scenario.particleRadius());
+            });
+        });
+
+        this->graph.precede(solverTask, integrateTask);
+    }
+}
+
+// the chunks of the graph cover the old particle range and the lists hold old indices
+template <typename Real>
+void BasicSimulation<Real>::resized() {
+    this->neighbours.invalidate();
+    this->buildGraph();
+}
+
+template <typename Real>
+void BasicSimulation<Real>::step(float frameTime) {
+    this->accumulator += std::max(frameTime, 0.0f) * this->timeScale;
+
+    this->steps = 0;
+    this->substeps = 0;
+
+    while(this->accumulator >= this->fixedStep && this->steps < this->maxSteps) {
+        if(this->solver->mixedSizes() && this->adaptive.update(this->particles, this->neighbours, this->solver->restDensity, this->pool)) this->resized();
+
+        this->particles.savePositions(this->pool);
+        this->advance(this->fixedStep);
+
+        this->accumulator -= this->fixedStep;
+        this->steps++;
+    }
+
+    if(this->accumulator >= this->fixedStep) this->accumulator = 0.0f;
+
+    this->alpha = this->accumulator / this->fixedStep;
+    this->particles.fillModelMatrices(this->modelMatrices, this->pool, this->alpha);
+}
+
+template <typename Real>
+void BasicSimulation<Real>::advance(float deltaTime) {
+    float remaining = deltaTime;
+
+    while(remaining > 0.0f) {
+        float step = this->timestep.next(this->particles, this->pool, this->solver->signalSpeed());
+
+        // spread what is left evenly so the step never ends on a sliver
+        float count = std::ceil(remaining / step);
+        step = remaining / count;
+
+        this->deltaTime = step;
+        this->graph.run(this->pool);
+        this->previousDeltaTime = step;
+
+        remaining = count > 1.0f ? remaining - step : 0.0f;
+        this->substeps++;
+    }
+}
+
+template class BasicSimulation<float>;
+template class BasicSimulation<double>;
@@ -0,0 +1,133 @@
+#include "../include/sleeping_cells.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SleepingCells::SleepingCells(float sleepSpeed, float densityChange, unsigned int calmSteps)
+: enabled(false),
+  sleepSpeed(sleepSpeed),
+  densityChange(densityChange),
+  calmSteps(calmSteps),
+  sleepingCells(0),
+  sleepingParticles(0) {}
+
+// everything wakes up, the calm counts start over
+void SleepingCells::reset() {
+    this->cellCalm.clear();
+    this->particleAsleep.clear();
+
+    this->sleepingCells = 0;
+    this->sleepingParticles = 0;
+}
+
+template <typename Real>
+void SleepingCells::update(BasicParticleSystem<Real> &particles, const UniformGrid &grid, float restDensity, ThreadPool &pool) {
+    if(!this->enabled || grid.mode != DENSE) {
+        if(!this->cellCalm.empty()) this->reset();
+        return;
+    }
+
+    const size_t n = particles.size();
+    const size_t cells = grid.cellCount();
+    const glm::ivec3 dims = grid.dims;
+
+    if(this->cellCalm.size() != cells) {
+        this->cellDensity.assign(cells, 0.0f);
+        this->cellCalm.assign(cells, 0);
+        this->cellRestless.assign(cells, 0);
+        this->cellAsleep.assign(cells, 0);
+    }
+
+    this->particleAsleep.resize(n);
+
+    const float sleepSpeed2 = this->sleepSpeed * this->sleepSpeed;
+    const float densityChange = this->densityChange * restDensity;
+
+    // fastest particle and mean density of every cell
+    pool.parallelFor(0, cells, [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; c++) {
+            uint32_t first = grid.cellStart[c];
+            uint32_t last = grid.cellEnd[c];
+
+            if(first == last) {
+                this->cellCalm[c] = 0;
+                this->cellRestless[c] = 0;
+                continue;
+            }
+
+            float speed2 = 0.0f;
+            float density = 0.0f;
+
+            for(uint32_t k = first; k < last; k++) {
+                uint32_t i = grid.particleIndex[k];
+
+                speed2 = std::max(speed2, (float)(particles.vx[i] * particles.vx[i] + particles.vy[i] * particles.vy[i] + particles.vz[i] * particles.vz[i]));
+                density += particles.density[i];
+            }
+
+            density /= last - first;
+
+            bool calm = speed2 < sleepSpeed2 && std::abs(density - this->cellDensity[c]) < densityChange;
+
+            this->cellDensity[c] = density;
+            this->cellCalm[c] = calm ? std::min(this->cellCalm[c] + 1, this->calmSteps) : 0;
+            this->cellRestless[c] = !calm;
+        }
+    });
+
+    // a neighbour that is not calm keeps a cell awake, so a wave travels into
+    // resting fluid one cell per step at most
+    this->sleepingCells = pool.parallelReduce(0, cells, (size_t)0, [&](size_t begin, size_t end) {
+        size_t count = 0;
+
+        for(size_t c = begin; c < end; c++) {
+            glm::ivec3 cell(c % dims.x, (c / dims.x) % dims.y, c / ((size_t)dims.x * dims.y));
+            glm::ivec3 low = glm::max(cell - 1, glm::ivec3(0));
+            glm::ivec3 high = glm::min(cell + 1, dims - 1);
+
+            bool disturbed = false;
+
+            for(int z = low.z; z <= high.z && !disturbed; z++) {
+                for(int y = low.y; y <= high.y && !disturbed; y++) {
+                    for(int x = low.x; x <= high.x && !disturbed; x++) {
+                        disturbed = this->cellRestless[x + dims.x * (y + dims.y * z)];
+                    }
+                }
+            }
+
+            if(disturbed) this->cellCalm[c] = 0;
+
+            this->cellAsleep[c] = this->cellCalm[c] >= this->calmSteps;
+            count += this->cellAsleep[c];
+        }
+
+        return count;
+    }, [](size_t a, size_t b) { return a + b; });
+
+    this->sleepingParticles = pool.parallelReduce(0, cells, (size_t)0, [&](size_t begin, size_t end) {
+        size_t count = 0;
+
+        for(size_t c = begin; c < end; c++) {
+            uint8_t asleep = this->cellAsleep[c];
+
+            for(uint32_t k = grid.cellStart[c]; k < grid.cellEnd[c]; k++) {
+                uint32_t i = grid.particleIndex[k];
+                this->particleAsleep[i] = asleep;
+
+                // whatever is left below sleepSpeed would otherwise come back on waking
+                if(asleep) {
+                    particles.vx[i] = 0;
+                    particles.vy[i] = 0;
+                    particles.vz[i] = 0;
+                }
+            }
+
+            if(asleep) count += grid.cellEnd[c] - grid.cellStart[c];
+        }
+
+        return count;
+    }, [](size_t a, size_t b) { return a + b; });
+}
+
+template void SleepingCells::update(ParticleSystem&, const UniformGrid&, float, ThreadPool&);
+template void SleepingCells::update(BasicParticleSystem<double>&, const UniformGrid&, float, ThreadPool&);
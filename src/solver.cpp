@@ -0,0 +1,73 @@
+#include "../include/solver.hpp"
+#include "../include/constants.hpp"
+
+#include <cmath>
+
+template <typename Real>
+BasicSolver<Real>::BasicSolver(Real smoothingRadius, Real spacing)
+: kernel(smoothingRadius),
+  fixedKernel(std::abs(smoothingRadius - BasicDefaultSphKernel<Real>::h) <= Real(FIXED_KERNEL_TOLERANCE) * BasicDefaultSphKernel<Real>::h),
+  fixedSimd(this->simd.level()),
+  restDensity(REST_DENSITY),
+  viscosity(VISCOSITY),
+  boundary(nullptr),
+  grid(nullptr),
+  sleeping(nullptr),
+  iterations(0),
+  totalIterations(0),
+  steps(0),
+  spacing(spacing) {
+    this->particleMass = this->kernel.latticeMass(spacing, this->restDensity);
+}
+
+template <typename Real>
+size_t BasicSolver<Real>::addTasks(TaskGraph &graph, BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, const float &deltaTime,
+                                   size_t start) {
+    size_t task = graph.add([this, &particles, &neighbours, &pool, &deltaTime] { this->step(particles, neighbours, pool, deltaTime); });
+    graph.precede(start, task);
+
+    return task;
+}
+
+template <typename Real>
+void BasicSolver<Real>::computeDensity(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours, size_t begin, size_t end) const {
+    if(this->fixedKernel) this->computeDensity(BasicDefaultSphKernel<Real>(), this->fixedSimd, particles, neighbours, begin, end);
+    else this->computeDensity(this->kernel, this->simd, particles, neighbours, begin, end);
+}
+
+template <typename Real>
+Real BasicSolver<Real>::boundaryDensity(const BasicParticleSystem<Real> &particles, size_t i) const {
+    return this->boundary ? this->boundary->density(this->kernel, particles, i) : Real(0);
+}
+
+template <typename Real>
+typename BasicSolver<Real>::Vec3 BasicSolver<Real>::boundaryGradient(const BasicParticleSystem<Real> &particles, size_t i) const {
+    return this->boundary ? this->boundary->gradient(this->kernel, particles, i) : Vec3(0);
+}
+
+template <typename Real>
+typename BasicSolver<Real>::Vec3 BasicSolver<Real>::boundaryPressureAcceleration(const BasicParticleSystem<Real> &particles, size_t i) const {
+    if(!this->boundary) return Vec3(0);
+
+    Real density = particles.density[i];
+    return -particles.pressure[i] / (density * density) * this->boundaryGradient(particles, i);
+}
+
+template <typename Real>
+bool BasicSolver<Real>::followPrediction(BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool) {
+    if(!this->grid || !neighbours.update(particles, *this->grid, pool, false)) return false;
+
+    if(this->boundary) this->boundary->update(particles, pool);
+
+    return true;
+}
+
+template <typename Real>
+void BasicSolver<Real>::countIterations(unsigned int iterations) {
+    this->iterations = iterations;
+    this->totalIterations += iterations;
+    this->steps++;
+}
+
+template class BasicSolver<float>;
+template class BasicSolver<double>;
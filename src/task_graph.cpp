@@ -0,0 +1,41 @@
+#include "../include/task_graph.hpp"
+
+size_t TaskGraph::add(std::function<void()> work) {
+    this->nodes.emplace_back(new Node());
+    this->nodes.back()->work = std::move(work);
+
+    return this->nodes.size() - 1;
+}
+
+void TaskGraph::precede(size_t before, size_t after) {
+    this->nodes[before]->successors.push_back(after);
+    this->nodes[after]->dependencies++;
+}
+
+void TaskGraph::submit(size_t index) {
+    this->pool->submit({ runNode, this, index, index + 1, &this->remaining });
+}
+
+void TaskGraph::runNode(void *context, size_t index, size_t) {
+    TaskGraph *graph = static_cast<TaskGraph*>(context);
+    Node &node = *graph->nodes[index];
+
+    node.work();
+
+    for(size_t successor : node.successors) {
+        if(graph->nodes[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) graph->submit(successor);
+    }
+}
+
+void TaskGraph::run(ThreadPool &pool) {
+    this->pool = &pool;
+    this->remaining.store(this->nodes.size());
+
+    for(std::unique_ptr<Node> &node : this->nodes) node->pending.store(node->dependencies);
+
+    for(size_t i = 0; i < this->nodes.size(); i++) {
+        if(this->nodes[i]->dependencies == 0) this->submit(i);
+    }
+
+    pool.wait(this->remaining);
+}
@@ -0,0 +1,150 @@
+#include "../include/thread_pool.hpp"
+
+#include <algorithm>
+
+static thread_local unsigned int workerIndex = 0;
+
+ThreadPool::ThreadPool(unsigned int threadCount, size_t chunkSize) : chunkSize(chunkSize), queued(0), stopping(false) {
+    if(threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    this->queues = std::vector<Queue>(threadCount);
+    for(Queue &queue : this->queues) queue.ring.resize(QUEUE_CAPACITY);
+
+    for(unsigned int i = 1; i < threadCount; i++) this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping = true;
+    }
+
+    this->wake.notify_all();
+
+    for(std::thread &worker : this->workers) worker.join();
+}
+
+void ThreadPool::execute(const Task &task) {
+    task.run(task.context, task.begin, task.end);
+    task.pending->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+bool ThreadPool::push(unsigned int index, const Task &task) {
+    Queue &queue = this->queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if(queue.count == QUEUE_CAPACITY) return false;
+
+    queue.ring[(queue.head + queue.count) % QUEUE_CAPACITY] = task;
+    queue.count++;
+
+    return true;
+}
+
+// owner side, newest first so freshly split work stays in cache
+bool ThreadPool::pop(unsigned int index, Task &task) {
+    Queue &queue = this->queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if(queue.count == 0) return false;
+
+    queue.count--;
+    task = queue.ring[(queue.head + queue.count) % QUEUE_CAPACITY];
+
+    return true;
+}
+
+// thief side, oldest first from the other queues
+bool ThreadPool::steal(unsigned int index, Task &task) {
+    for(size_t k = 1; k < this->queues.size(); k++) {
+        Queue &queue = this->queues[(index + k) % this->queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if(queue.count == 0) continue;
+
+        task = queue.ring[queue.head];
+        queue.head = (queue.head + 1) % QUEUE_CAPACITY;
+        queue.count--;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool ThreadPool::tryRunOne(unsigned int index) {
+    Task task;
+
+    if(!this->pop(index, task) && !this->steal(index, task)) return false;
+
+    this->queued.fetch_sub(1, std::memory_order_relaxed);
+    execute(task);
+
+    return true;
+}
+
+void ThreadPool::submit(const Task &task) {
+    // counted before it is published, a thief that pops it right away must not
+    // take queued below zero
+    this->queued.fetch_add(1, std::memory_order_relaxed);
+
+    // a full deque degrades to running the task right here
+    if(!this->push(workerIndex, task)) {
+        this->queued.fetch_sub(1, std::memory_order_relaxed);
+        execute(task);
+        return;
+    }
+
+    { std::lock_guard<std::mutex> lock(this->sleepMutex); }
+    this->wake.notify_one();
+}
+
+void ThreadPool::wait(std::atomic<size_t> &pending) {
+    while(pending.load(std::memory_order_acquire) > 0) {
+        if(!this->tryRunOne(workerIndex)) std::this_thread::yield();
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    workerIndex = index;
+
+    while(true) {
+        if(this->tryRunOne(index)) continue;
+
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wake.wait(lock, [&] { return this->stopping || this->queued.load(std::memory_order_relaxed) > 0; });
+
+        if(this->stopping) return;
+    }
+}
+
+static void runChunk(void *context, size_t begin, size_t end) {
+    (*static_cast<const std::function<void(size_t, size_t)>*>(context))(begin, end);
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &body, size_t chunkSize) {
+    if(begin >= end) return;
+
+    if(chunkSize == 0) chunkSize = this->chunkSize;
+
+    if(this->queues.size() == 1 || end - begin <= chunkSize) {
+        body(begin, end);
+        return;
+    }
+
+    size_t chunks = (end - begin + chunkSize - 1) / chunkSize;
+    std::atomic<size_t> pending(chunks);
+
+    void *context = const_cast<std::function<void(size_t, size_t)>*>(&body);
+
+    // push from the back so the owner pops the first chunk first
+    for(size_t c = chunks; c-- > 1;) {
+        size_t b = begin + c * chunkSize;
+        this->submit({ runChunk, context, b, std::min(b + chunkSize, end), &pending });
+    }
+
+    this->wake.notify_all();
+
+    execute({ runChunk, context, begin, std::min(begin + chunkSize, end), &pending });
+    this->wait(pending);
+}
@@ -0,0 +1,56 @@
+#include "../include/timestep_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TimestepController::TimestepController(float smoothingRadius, float cflFactor, float forceFactor, float minStep, float maxStep)
+: smoothingRadius(smoothingRadius),
+  cflFactor(cflFactor),
+  forceFactor(forceFactor),
+  minStep(minStep),
+  maxStep(maxStep),
+  maxSpeed(0.0f),
+  maxAcceleration(0.0f),
+  step(maxStep) {}
+
+template <typename Real>
+float TimestepController::next(const BasicParticleSystem<Real> &particles, ThreadPool &pool, float signalSpeed) {
+    // x holds the largest squared speed, y the largest squared acceleration and
+    // z the negated smallest support scale, so all three reduce with max
+    glm::vec3 maxima = pool.parallelReduce(0, particles.size(), glm::vec3(0.0f, 0.0f, -1.0f), [&](size_t begin, size_t end) {
+        const Real *vx = particles.vx.data(), *vy = particles.vy.data(), *vz = particles.vz.data();
+        const Real *ax = particles.ax.data(), *ay = particles.ay.data(), *az = particles.az.data();
+        const Real *smoothing = particles.smoothing.data();
+
+        glm::vec3 partial(0.0f, 0.0f, -1.0f);
+
+        for(size_t i = begin; i < end; i++) {
+            Real speed2 = vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i];
+            Real accelerationY = ay[i] + particles.gravity;
+            Real acceleration2 = ax[i] * ax[i] + accelerationY * accelerationY + az[i] * az[i];
+
+            partial = glm::max(partial, glm::vec3(speed2, acceleration2, -smoothing[i]));
+        }
+
+        return partial;
+    }, [](glm::vec3 a, glm::vec3 b) { return glm::max(a, b); });
+
+    this->maxSpeed = std::sqrt(maxima.x);
+    this->maxAcceleration = std::sqrt(maxima.y);
+
+    // split particles have a smaller support and bound the step with it
+    float h = this->smoothingRadius * -maxima.z;
+    float step = this->maxStep;
+
+    float speed = signalSpeed + this->maxSpeed;
+    if(speed > 0.0f) step = std::min(step, this->cflFactor * h / speed);
+
+    if(this->maxAcceleration > 0.0f) step = std::min(step, this->forceFactor * std::sqrt(h / this->maxAcceleration));
+
+    this->step = std::max(step, this->minStep);
+
+    return this->step;
+}
+
+template float TimestepController::next(const ParticleSystem&, ThreadPool&, float);
+template float TimestepController::next(const BasicParticleSystem<double>&, ThreadPool&, float);
@@ -0,0 +1,188 @@
+#include "../include/uniform_grid.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+UniformGrid::UniformGrid(float cellSize, glm::vec3 domainMin, glm::vec3 domainMax)
+: mode(DENSE), cellSize(cellSize), origin(domainMin), reorderInterval(REORDER_INTERVAL), tableMask(0), generation(0), buildCount(0) {
+    this->dims = glm::max(glm::ivec3(glm::ceil((domainMax - domainMin) / cellSize)), glm::ivec3(1));
+    this->activeCells = (size_t)this->dims.x * this->dims.y * this->dims.z;
+
+    this->cellStart.resize(this->activeCells);
+    this->cellEnd.resize(this->activeCells);
+}
+
+UniformGrid::UniformGrid(float cellSize, size_t particleCount)
+: mode(HASHED), cellSize(cellSize), origin(0.0f), dims(0), reorderInterval(REORDER_INTERVAL), activeCells(0), tableMask(0), generation(0), buildCount(0) {
+    this->reserveTable(particleCount);
+}
+
+void UniformGrid::reserve(size_t capacity) {
+    this->particleIndex.reserve(capacity);
+    this->mortonKeys.reserve(capacity);
+    this->order.reserve(capacity);
+
+    if(this->mode == HASHED) this->reserveTable(capacity);
+}
+
+// power of two table with roughly two slots per particle keeps probe chains short,
+// turns the modulo into a mask and always leaves free slots so a probe ends
+void UniformGrid::reserveTable(size_t particleCount) {
+    size_t tableSize = 1;
+    while(tableSize < 2 * particleCount) tableSize <<= 1;
+
+    if(tableSize > this->slotGeneration.size()) {
+        this->tableMask = tableSize - 1;
+        this->slotKey.resize(tableSize);
+        this->slotCell.resize(tableSize);
+
+        // a regrown table starts empty under every generation
+        this->slotGeneration.assign(tableSize, 0);
+        this->generation = 0;
+    }
+
+    // there are never more occupied cells than particles
+    if(particleCount > this->cellStart.size()) {
+        this->cellStart.resize(particleCount);
+        this->cellEnd.resize(particleCount);
+    }
+}
+
+template <typename Real>
+glm::ivec3 UniformGrid::cellCoord(glm::vec<3, Real> position) const {
+    glm::ivec3 cell = glm::ivec3(glm::floor((position - glm::vec<3, Real>(this->origin)) / Real(this->cellSize)));
+
+    if(this->mode == DENSE) return glm::clamp(cell, glm::ivec3(0), this->dims - 1);
+
+    return cell;
+}
+
+uint32_t UniformGrid::slotOf(const glm::ivec3 &cell) const {
+    return (((uint32_t)cell.x * 73856093u) ^
+            ((uint32_t)cell.y * 19349663u) ^
+            ((uint32_t)cell.z * 83492791u)) & this->tableMask;
+}
+
+uint32_t UniformGrid::insertCell(const glm::ivec3 &cell) {
+    uint32_t slot = this->slotOf(cell);
+
+    while(this->slotGeneration[slot] == this->generation) {
+        if(this->slotKey[slot] == cell) return this->slotCell[slot];
+        slot = (slot + 1) & this->tableMask;
+    }
+
+    this->slotGeneration[slot] = this->generation;
+    this->slotKey[slot] = cell;
+    this->slotCell[slot] = this->activeCells;
+
+    return this->activeCells++;
+}
+
+// EMPTY for cells outside a dense grid or not occupied in a hashed one
+uint32_t UniformGrid::cellIndex(const glm::ivec3 &cell) const {
+    if(this->mode == DENSE) {
+        if(glm::any(glm::lessThan(cell, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(cell, this->dims))) return EMPTY;
+
+        return cell.x + this->dims.x * (cell.y + this->dims.y * cell.z);
+    }
+
+    uint32_t slot = this->slotOf(cell);
+
+    while(this->slotGeneration[slot] == this->generation) {
+        if(this->slotKey[slot] == cell) return this->slotCell[slot];
+        slot = (slot + 1) & this->tableMask;
+    }
+
+    return EMPTY;
+}
+
+// spreads the low 10 bits of v so there are two zero bits between each of them
+uint32_t UniformGrid::spreadBits(uint32_t v) {
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+
+    return v;
+}
+
+// dense cells are never negative, hashed ones are biased into range and wrap
+// every 1024 cells which only costs locality, not correctness
+uint32_t UniformGrid::mortonCode(const glm::ivec3 &cell) const {
+    glm::uvec3 c = glm::uvec3(this->mode == DENSE ? cell : cell + glm::ivec3(512));
+
+    return spreadBits(c.x) | (spreadBits(c.y) << 1) | (spreadBits(c.z) << 2);
+}
+
+template <typename Real>
+void UniformGrid::reorder(BasicParticleSystem<Real> &particles, ThreadPool &pool) {
+    const size_t n = particles.size();
+
+    // code in the high word, index in the low one, a plain sort gives the permutation
+    this->mortonKeys.resize(n);
+    pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            this->mortonKeys[i] = ((uint64_t)this->mortonCode(this->cellCoord(particles.position(i))) << 32) | i;
+        }
+    });
+
+    std::sort(this->mortonKeys.begin(), this->mortonKeys.end());
+
+    this->order.resize(n);
+    for(size_t i = 0; i < n; i++) this->order[i] = (uint32_t)this->mortonKeys[i];
+
+    particles.permute(this->order);
+}
+
+template <typename Real>
+bool UniformGrid::build(BasicParticleSystem<Real> &particles, ThreadPool &pool, bool allowReorder) {
+    const size_t n = particles.size();
+    uint32_t *hash = particles.hash.data();
+
+    bool reordered = allowReorder && this->reorderInterval > 0 && this->buildCount++ % this->reorderInterval == 0;
+    if(reordered) this->reorder(particles, pool);
+
+    if(this->mode == DENSE) {
+        pool.parallelFor(0, n, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) hash[i] = this->cellIndex(this->cellCoord(particles.position(i)));
+        });
+    } else {
+        // a store that grew since the last build (splitting) regrows the tables first
+        this->reserveTable(n);
+
+        // table inserts hand out cell ids in order so this part stays serial,
+        // bumping the generation empties the table without touching it
+        if(++this->generation == 0) {
+            std::fill(this->slotGeneration.begin(), this->slotGeneration.end(), 0);
+            this->generation = 1;
+        }
+
+        this->activeCells = 0;
+        for(size_t i = 0; i < n; i++) hash[i] = this->insertCell(this->cellCoord(particles.position(i)));
+    }
+
+    // counting sort: histogram, exclusive prefix sum, scatter
+    std::fill(this->cellEnd.begin(), this->cellEnd.begin() + this->activeCells, 0);
+    for(size_t i = 0; i < n; i++) this->cellEnd[hash[i]]++;
+
+    uint32_t offset = 0;
+    for(size_t c = 0; c < this->activeCells; c++) {
+        this->cellStart[c] = offset;
+        offset += this->cellEnd[c];
+        this->cellEnd[c] = this->cellStart[c];
+    }
+
+    this->particleIndex.resize(n);
+    for(size_t i = 0; i < n; i++) this->particleIndex[this->cellEnd[hash[i]]++] = i;
+
+    return reordered;
+}
+
+template glm::ivec3 UniformGrid::cellCoord(glm::vec3) const;
+template glm::ivec3 UniformGrid::cellCoord(glm::dvec3) const;
+template void UniformGrid::reorder(ParticleSystem&, ThreadPool&);
+template void UniformGrid::reorder(BasicParticleSystem<double>&, ThreadPool&);
+template bool UniformGrid::build(ParticleSystem&, ThreadPool&, bool);
+template bool UniformGrid::build(BasicParticleSystem<double>&, ThreadPool&, bool);
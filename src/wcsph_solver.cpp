@@ -0,0 +1,110 @@
+#include "../include/wcsph_solver.hpp"
+#include "../include/constants.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+template <typename Real>
+BasicWcsphSolver<Real>::BasicWcsphSolver(Real smoothingRadius, Real spacing, Real soundSpeed)
+: BasicSolver<Real>(smoothingRadius, spacing),
+  exponent(TAIT_EXPONENT),
+  packedForces(PACKED_FORCES && std::is_same<Real, float>::value) {
+    this->stiffness = this->restDensity * soundSpeed * soundSpeed / this->exponent;
+}
+
+template <typename Real>
+void BasicWcsphSolver<Real>::step(BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, float) {
+    this->packed.resize(SimdKernels::PACKED_WORDS * particles.size());
+
+    pool.parallelFor(0, particles.size(), [&](size_t begin, size_t end) {
+        this->computeDensity(particles, neighbours, begin, end);
+        this->computePressure(particles, begin, end);
+        this->pack(particles, begin, end);
+    });
+
+    pool.parallelFor(0, particles.size(), [&](size_t begin, size_t end) {
+        this->forEachAwake(begin, end, [&](size_t b, size_t e) { this->computeForces(particles, neighbours, b, e); });
+    });
+}
+
+// density[c] -> pressure[c] -> join -> forces[c] -> join, forces read the density
+// and pressure of neighbours in other chunks. only the force pass skips
+// sleeping particles, their densities and pressures stay current for the
+// fluid around them and for the sleeping cells to notice being compressed
+template <typename Real>
+size_t BasicWcsphSolver<Real>::addTasks(TaskGraph &graph, BasicParticleSystem<Real> &particles, NeighbourList &neighbours, ThreadPool &pool, const float &,
+                                        size_t start) {
+    const size_t n = particles.size();
+
+    // the graph is rebuilt whenever the particle count changes
+    this->packed.resize(SimdKernels::PACKED_WORDS * n);
+
+    size_t pressureJoin = graph.add([] {});
+    size_t forceJoin = graph.add([] {});
+
+    for(size_t begin = 0; begin < n; begin += pool.chunkSize) {
+        size_t end = std::min(begin + pool.chunkSize, n);
+
+        size_t densityTask = graph.add([this, &particles, &neighbours, begin, end] { this->computeDensity(particles, neighbours, begin, end); });
+        size_t pressureTask = graph.add([this, &particles, begin, end] {
+            this->computePressure(particles, begin, end);
+            this->pack(particles, begin, end);
+        });
+        size_t forceTask = graph.add([this, &particles, &neighbours, begin, end] {
+            this->forEachAwake(begin, end, [&](size_t b, size_t e) { this->computeForces(particles, neighbours, b, e); });
+        });
+
+        graph.precede(start, densityTask);
+        graph.precede(densityTask, pressureTask);
+        graph.precede(pressureTask, pressureJoin);
+        graph.precede(pressureJoin, forceTask);
+        graph.precede(forceTask, forceJoin);
+    }
+
+    return forceJoin;
+}
+
+template <typename Real>
+void BasicWcsphSolver<Real>::computePressure(BasicParticleSystem<Real> &particles, size_t begin, size_t end) const {
+    const Real *density = particles.density.data();
+    Real *pressure = particles.pressure.data();
+
+    for(size_t i = begin; i < end; i++) {
+        pressure[i] = taitPressure(density[i], this->restDensity, this->stiffness, this->exponent);
+    }
+}
+
+template <typename Real>
+void BasicWcsphSolver<Real>::computeForces(BasicParticleSystem<Real> &particles, const NeighbourList &neighbours, size_t begin, size_t end) const {
+    if(this->fixedKernel) this->computeForces(BasicDefaultSphKernel<Real>(), this->fixedSimd, particles, neighbours, begin, end);
+    else this->computeForces(this->kernel, this->simd, particles, neighbours, begin, end);
+}
+
+template <typename Real>
+template <typename Kernel>
+void BasicWcsphSolver<Real>::computeForces(const Kernel &kernel, const BasicSimdKernels<Kernel> &simd, BasicParticleSystem<Real> &particles,
+                                           const NeighbourList &neighbours, size_t begin, size_t end) const {
+    const Real *density = particles.density.data();
+    Real *ax = particles.ax.data(), *ay = particles.ay.data(), *az = particles.az.data();
+
+    for(size_t i = begin; i < end; i++) {
+        BasicForceSums<Real> sums = this->packedForces ? simd.forceSums(kernel, particles, this->packed.data(), i, neighbours.begin(i), neighbours.count(i))
+                                                       : simd.forceSums(kernel, particles, i, neighbours.begin(i), neighbours.count(i));
+
+        glm::vec<3, Real> acceleration = -this->particleMass * sums.pressure
+                               + this->viscosity * this->particleMass / density[i] * sums.viscosity
+                               + this->boundaryPressureAcceleration(particles, i);
+
+        ax[i] = acceleration.x;
+        ay[i] = acceleration.y;
+        az[i] = acceleration.z;
+    }
+}
+
+template <typename Real>
+void BasicWcsphSolver<Real>::pack(const BasicParticleSystem<Real> &particles, size_t begin, size_t end) {
+    if(this->packedForces) this->simd.pack(particles, begin, end, this->packed.data());
+}
+
+template class BasicWcsphSolver<float>;
+template class BasicWcsphSolver<double>;
@@ -9,7 +9,10 @@
 #include "../include/glm/gtc/type_ptr.hpp"
 #include "../include/mesh.hpp"
 #include "../include/model.hpp"
-#include "../include/particle.hpp"
+#include "../include/particle_system.hpp"
+#include "../include/scenario.hpp"
+#include "../include/sdf_collider.hpp"
+#include "../include/simulation.hpp"
 
 #include <cstdlib>
 #include <iostream>
@@ -55,6 +58,54 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
+// simulation controls, number keys pick the pressure solver of the simulation
+// attached to the window
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if(action != GLFW_PRESS) return;
+
+    Simulation *simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(window));
+    if(simulation == NULL) return;
+
+    if(key == GLFW_KEY_1)
+        simulation->setSolver(WCSPH);
+    if(key == GLFW_KEY_2)
+        simulation->setSolver(PCISPH);
+    if(key == GLFW_KEY_3)
+        simulation->setSolver(DFSPH);
+    if(key == GLFW_KEY_4)
+        simulation->setSolver(IISPH);
+    if(key == GLFW_KEY_5)
+        simulation->setSolver(PBF);
+
+    if(key >= GLFW_KEY_1 && key <= GLFW_KEY_5)
+        std::cout << "solver " << simulation->solver->name() << std::endl;
+
+    // brackets slow the simulation clock down or speed it up relative to real time
+    if(key == GLFW_KEY_LEFT_BRACKET)
+        simulation->timeScale *= 0.5f;
+    if(key == GLFW_KEY_RIGHT_BRACKET)
+        simulation->timeScale *= 2.0f;
+
+    if(key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET)
+        std::cout << "time scale " << simulation->timeScale << std::endl;
+
+    // r switches adaptive resolution, particles near the camera and the free surface are split
+    if(key == GLFW_KEY_R) {
+        simulation->adaptive.enabled = !simulation->adaptive.enabled;
+        std::cout << "adaptive resolution " << (simulation->adaptive.enabled ? "on" : "off") << std::endl;
+
+        if(simulation->adaptive.enabled && !simulation->solver->mixedSizes())
+            std::cout << "adaptive resolution paused under " << simulation->solver->name() << std::endl;
+    }
+
+    // z switches sleeping of resting cells
+    if(key == GLFW_KEY_Z) {
+        simulation->sleeping.enabled = !simulation->sleeping.enabled;
+        std::cout << "sleeping " << (simulation->sleeping.enabled ? "on" : "off") << std::endl;
+    }
+}
+
 // query GLFW when relevant keys are pressed
 void processInput(GLFWwindow *window)
 {
@@ -74,7 +125,11 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
-int main() {
+// the scenario file is the first argument, SCENARIO_PATH without one
+int main(int argc, char **argv) {
+
+    Scenario scenario;
+    if(!scenario.load(argc > 1 ? argv[1] : SCENARIO_PATH)) return -1;
 
     // GLFW init and config
     glfwInit();
@@ -114,23 +169,28 @@ int main() {
     Shader modelShader("resources/shaders/vertex/modelLoadNoTextures.vs", "resources/shaders/fragment/modelLoadNoTextures.fs");
     Model model("resources/models/sphere/sphere.obj");
 
-    std::vector<glm::mat4> modelMatrices;
-    std::vector<Particle*> particles;
-        
-    for(int i = 0; i < PARTICLE_ROW_COUNT; i++) {
-        for(int j = 0; j < PARTICLE_ROW_COUNT; j++) {
-            for(int k = 0; k < PARTICLE_ROW_COUNT; k++) {
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(TRANSLATE) * glm::vec3(i, j, k));
-                model = glm::scale(model, glm::vec3(SCALE));
-
-                Particle *particle = new Particle(model[3], model);
-
-                particles.push_back(particle);
-                modelMatrices.push_back(model);
-            }
-        }
+    Simulation simulation(scenario);
+    model.reserveInstances(scenario.capacity());
+
+    // a sphere resting on the floor in the corner the fluid flows towards. its
+    // distance field is voxelized on the first run and read back afterwards
+    // from the build directory, another box size or spacing voxelizes it again
+    Model colliderModel("resources/models/sphere/sphere.obj");
+    std::vector<glm::mat4> colliderMatrices;
+
+    if(scenario.collider) {
+        float radius = COLLIDER_RADIUS_FACTOR * scenario.boxSize;
+        float offset = COLLIDER_OFFSET_FACTOR * scenario.boxSize;
+        glm::mat4 colliderTransform = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(offset, radius, offset)), glm::vec3(radius));
+
+        simulation.colliders.emplace_back(colliderModel.triangles(colliderTransform), COLLIDER_CELL_FACTOR * scenario.spacing, COLLIDER_BAND_FACTOR * scenario.spacing,
+                                          simulation.pool, COLLIDER_CACHE_PATH);
+
+        colliderMatrices.push_back(glm::scale(glm::mat4(1.0f), glm::vec3(SCALE)) * colliderTransform);
     }
+
+    glfwSetWindowUserPointer(window, &simulation);
+    glfwSetKeyCallback(window, key_callback);
     
     // render loop
     while(!glfwWindowShouldClose(window)) {
@@ -152,17 +212,13 @@ int main() {
         modelShader.setMatrix1("view", value_ptr(view));
 
         modelShader.setVec3("viewPos", camera.position);
-        modelMatrices.clear();
-
-        Particle::sortParticles(particles);
-        std::unordered_map<uint32_t, uint32_t> nTable = Particle::neighbourTable(particles);
 
-        for(auto particle : particles) {
-            particle->getNeighbours(particles, nTable);
-            modelMatrices.push_back(particle->updatePhysics(deltaTime));
-        }
+        // the camera lives in render units, the simulation in particle units
+        simulation.adaptive.focus = camera.position / SCALE;
+        simulation.step(deltaTime);
 
-        model.drawInstanced(modelShader, modelMatrices); 
+        model.drawInstanced(modelShader, simulation.modelMatrices); 
+        if(!colliderMatrices.empty()) colliderModel.drawInstanced(modelShader, colliderMatrices);
 
         glfwSwapBuffers(window);
         glfwPollEvents();    
@@ -171,6 +227,10 @@ int main() {
 
     modelShader.del();
 
+    std::cout << "neighbour lists rebuilt " << simulation.neighbours.rebuilds << "/" << simulation.neighbours.updates << " frames" << std::endl;
+    std::cout << simulation.particles.size() << " particles at exit, " << simulation.sleeping.sleepingParticles << " asleep" << std::endl;
+    std::cout << simulation.solver->name() << " averaged " << simulation.solver->averageIterations() << " iterations per step" << std::endl;
+
     // GLFW terminate and clear allocated GLFW resources
     glfwTerminate();
     return 0;